@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_AXIS_SNAPSHOT_H
+#define SCHUNK_SDH_ROS_AXIS_SNAPSHOT_H
+
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/sdh.h>
+
+#include <schunk_sdh_ros/call_profiler.h>
+
+namespace schunk_sdh_ros
+{
+
+/// signals that can be acquired with readAxisSnapshot()
+enum AxisSignal
+{
+  SIGNAL_ANGLES = 1 << 0,
+  SIGNAL_VELOCITIES = 1 << 1,
+  SIGNAL_STATE = 1 << 2,
+  SIGNAL_TEMPERATURES = 1 << 3,
+  SIGNAL_ALL = SIGNAL_ANGLES | SIGNAL_VELOCITIES | SIGNAL_STATE | SIGNAL_TEMPERATURES
+};
+
+/*!
+ * \brief Feedback of all axes acquired in one go.
+ *
+ * All values are in SDHLibrary units (degrees, degrees/s, degrees Celsius) and axis order. Signals that were not
+ * requested in a cycle keep their last value, \c updated tells which ones are fresh.
+ */
+struct AxisSnapshot
+{
+  ros::Time stamp;   // midpoint of the acquisition
+  double io_time;    // wall time spent talking to the hand [s]
+  bool valid;        // false if any of the reads failed, the values must not be used then
+  unsigned int updated;  // AxisSignal bits read in the last acquisition
+
+  std::vector<double> angles;
+  std::vector<double> velocities;
+  std::vector<SDH::cSDH::eAxisState> state;
+  std::vector<double> temperatures;
+
+  AxisSnapshot() :
+      io_time(0.0), valid(false), updated(0)
+  {
+  }
+};
+
+/// angles of all axes with the time they were acquired, handed from the update loop to the action callbacks
+struct StampedAngles
+{
+  ros::Time stamp;              // see AxisSnapshot::stamp
+  std::vector<double> angles;   // [deg]
+};
+
+/*!
+ * \brief Reads the requested signals of the given axes.
+ *
+ * The requests are issued back-to-back without any processing in between, so the values belong to the same instant
+ * as far as the protocol allows. SDHLibrary only offers blocking request/response calls, hence this still costs one
+ * round trip per signal.
+ * \param sdh connected hand
+ * \param axes axes to read
+ * \param temperature_sensors temperature sensors to read
+ * \param signals AxisSignal bits to read
+ * \param snapshot receives the values
+ * \param profiler times the individual calls if given
+ * \return snapshot.valid
+ */
+inline bool readAxisSnapshot(SDH::cSDH &sdh, const std::vector<int> &axes, const std::vector<int> &temperature_sensors,
+                             unsigned int signals, AxisSnapshot &snapshot, CallProfiler *profiler = 0)
+{
+  const ros::WallTime start = ros::WallTime::now();
+  const ros::Time stamp_start = ros::Time::now();
+  snapshot.valid = false;
+  snapshot.updated = 0;
+  try
+  {
+    if (signals & SIGNAL_ANGLES)
+    {
+      CallProfiler::Scope scope(profiler, CALL_GET_AXIS_ACTUAL_ANGLE);
+      snapshot.angles = sdh.GetAxisActualAngle(axes);
+    }
+    if (signals & SIGNAL_VELOCITIES)
+    {
+      CallProfiler::Scope scope(profiler, CALL_GET_AXIS_ACTUAL_VELOCITY);
+      snapshot.velocities = sdh.GetAxisActualVelocity(axes);
+    }
+    if (signals & SIGNAL_STATE)
+    {
+      CallProfiler::Scope scope(profiler, CALL_GET_AXIS_ACTUAL_STATE);
+      snapshot.state = sdh.GetAxisActualState(axes);
+    }
+    if (signals & SIGNAL_TEMPERATURES)
+    {
+      CallProfiler::Scope scope(profiler, CALL_GET_TEMPERATURE);
+      snapshot.temperatures = sdh.GetTemperature(temperature_sensors);
+    }
+    snapshot.valid = (!(signals & SIGNAL_ANGLES) || snapshot.angles.size() == axes.size())
+        && (!(signals & SIGNAL_VELOCITIES) || snapshot.velocities.size() == axes.size())
+        && (!(signals & SIGNAL_STATE) || snapshot.state.size() == axes.size());
+    if (snapshot.valid)
+      snapshot.updated = signals;
+  }
+  catch (SDH::cSDHLibraryException* e)
+  {
+    ROS_ERROR("An exception was caught: %s", e->what());
+    delete e;
+  }
+  snapshot.io_time = (ros::WallTime::now() - start).toSec();
+  snapshot.stamp = stamp_start + ros::Duration(snapshot.io_time / 2.0);
+  return snapshot.valid;
+}
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_AXIS_SNAPSHOT_H
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_CALL_PROFILER_H
+#define SCHUNK_SDH_ROS_CALL_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/KeyValue.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace schunk_sdh_ros
+{
+
+/// SDHLibrary calls timed by CallProfiler
+enum HardwareCall
+{
+  CALL_STOP,
+  CALL_SET_CONTROLLER,
+  CALL_SET_AXIS_TARGET_ANGLE,
+  CALL_MOVE_HAND,
+  CALL_SET_AXIS_TARGET_VELOCITY,
+  CALL_GET_AXIS_ACTUAL_ANGLE,
+  CALL_GET_AXIS_ACTUAL_VELOCITY,
+  CALL_GET_AXIS_ACTUAL_STATE,
+  CALL_GET_TEMPERATURE,
+  CALL_DSA_UPDATE_FRAME,
+  CALL_DSA_SET_FRAMERATE,
+  CALL_DSA_GET_CONTACT_INFO,
+  CALL_COUNT
+};
+
+inline const char *hardwareCallName(int call)
+{
+  static const char *names[CALL_COUNT] = {
+    "Stop", "SetController", "SetAxisTargetAngle", "MoveHand", "SetAxisTargetVelocity", "GetAxisActualAngle",
+    "GetAxisActualVelocity", "GetAxisActualState", "GetTemperature", "UpdateFrame", "SetFramerate", "GetContactInfo"
+  };
+  return names[call];
+}
+
+/*!
+ * \brief Lock-free latency histogram with logarithmic buckets.
+ *
+ * Like an HDR histogram, every power of two is split into 16 linear sub-buckets, so any recorded value is known to
+ * within 6.25 % over the whole range from 1 ns to 68 s. Any thread may record(), a single reader takes windowed
+ * summaries with summarize().
+ */
+class LatencyHistogram
+{
+public:
+  struct Summary
+  {
+    uint64_t count;  // samples in the window
+    double p50;      // [s]
+    double p99;      // [s]
+    double max;      // [s]
+
+    Summary() :
+        count(0), p50(0.0), p99(0.0), max(0.0)
+    {
+    }
+  };
+
+  LatencyHistogram() :
+      counts_(kBuckets), previous_(kBuckets, 0), max_(0)
+  {
+    for (size_t i = 0; i < counts_.size(); i++)
+      counts_[i].store(0, std::memory_order_relaxed);
+  }
+
+  /// records one latency [ns]
+  void record(uint64_t ns)
+  {
+    counts_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /// statistics of the samples recorded since the previous call
+  Summary summarize()
+  {
+    Summary s;
+    window_.resize(kBuckets);
+    for (size_t i = 0; i < kBuckets; i++)
+    {
+      const uint64_t count = counts_[i].load(std::memory_order_relaxed);
+      window_[i] = count - previous_[i];
+      previous_[i] = count;
+      s.count += window_[i];
+    }
+    s.max = max_.exchange(0, std::memory_order_relaxed) * 1e-9;
+    if (s.count == 0)
+      return s;
+
+    const uint64_t rank50 = (s.count * 50 + 99) / 100;
+    const uint64_t rank99 = (s.count * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++)
+    {
+      if (window_[i] == 0)
+        continue;
+      const uint64_t before = seen;
+      seen += window_[i];
+      if (before < rank50 && seen >= rank50)
+        s.p50 = value(i) * 1e-9;
+      if (before < rank99 && seen >= rank99)
+      {
+        s.p99 = value(i) * 1e-9;
+        break;
+      }
+    }
+    return s;
+  }
+
+private:
+  static const int kSubBits = 4;                      // 16 sub-buckets per power of two
+  static const int kMaxBits = 36;                     // values are capped at 2^36 ns
+  static const size_t kBuckets = (2 << kSubBits) + (kMaxBits - kSubBits) * (1 << kSubBits);
+
+  static size_t bucket(uint64_t ns)
+  {
+    const uint64_t linear = 2 << kSubBits;
+    if (ns < linear)
+      return ns;
+    if (ns >= (uint64_t(1) << kMaxBits))
+      ns = (uint64_t(1) << kMaxBits) - 1;
+    const int msb = 63 - __builtin_clzll(ns);
+    const int shift = msb - kSubBits;
+    const uint64_t top = ns >> shift;  // in [16, 32)
+    return linear + (shift - 1) * (1 << kSubBits) + (top - (1 << kSubBits));
+  }
+
+  /// midpoint of a bucket [ns]
+  static double value(size_t index)
+  {
+    const size_t linear = 2 << kSubBits;
+    if (index < linear)
+      return index;
+    const int shift = (index - linear) / (1 << kSubBits) + 1;
+    const uint64_t top = (1 << kSubBits) + (index - linear) % (1 << kSubBits);
+    return (top << shift) + (uint64_t(1) << shift) / 2.0;
+  }
+
+  std::vector<std::atomic<uint64_t> > counts_;
+  std::vector<uint64_t> previous_;  // reader only
+  std::vector<uint64_t> window_;    // reader only
+  std::atomic<uint64_t> max_;
+};
+
+/*!
+ * \brief Latency histograms of all hardware calls.
+ *
+ * A call is timed by putting a Scope around it. The cost is two reads of the monotonic clock and two relaxed atomic
+ * operations, which is negligible compared to a bus round trip, so it stays enabled in production.
+ */
+class CallProfiler
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// times the enclosing block, also when it is left by an exception
+  class Scope
+  {
+  public:
+    Scope(CallProfiler *profiler, HardwareCall call) :
+        profiler_(profiler), call_(call), start_(profiler ? Clock::now() : Clock::time_point())
+    {
+    }
+
+    ~Scope()
+    {
+      if (profiler_)
+        profiler_->record(call_, Clock::now() - start_);
+    }
+
+  private:
+    CallProfiler *profiler_;
+    HardwareCall call_;
+    Clock::time_point start_;
+  };
+
+  CallProfiler() :
+      histograms_(CALL_COUNT)
+  {
+  }
+
+  void record(HardwareCall call, Clock::duration duration)
+  {
+    histograms_[call].record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  }
+
+  /// statistics of a call since the previous summarize() of that call, single reader only
+  LatencyHistogram::Summary summarize(HardwareCall call)
+  {
+    return histograms_[call].summarize();
+  }
+
+  /*!
+   * \brief Summarizes all calls made since the previous call into one status per call.
+   *
+   * \param prefix prepended to the call names, e.g. the node namespace
+   * \param msg receives the statistics of all calls that were made in the window, latencies in seconds
+   */
+  void summarize(const std::string &prefix, diagnostic_msgs::DiagnosticArray &msg)
+  {
+    msg.header.stamp = ros::Time::now();
+    msg.status.clear();
+    for (int call = 0; call < CALL_COUNT; call++)
+    {
+      const LatencyHistogram::Summary s = summarize(static_cast<HardwareCall>(call));
+      if (s.count == 0)
+        continue;
+      diagnostic_msgs::DiagnosticStatus status;
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+      status.name = prefix + hardwareCallName(call);
+      diagnostic_msgs::KeyValue kv;
+      kv.key = "count";
+      kv.value = boost::lexical_cast<std::string>(s.count);
+      status.values.push_back(kv);
+      kv.key = "p50";
+      kv.value = boost::lexical_cast<std::string>(s.p50);
+      status.values.push_back(kv);
+      kv.key = "p99";
+      kv.value = boost::lexical_cast<std::string>(s.p99);
+      status.values.push_back(kv);
+      kv.key = "max";
+      kv.value = boost::lexical_cast<std::string>(s.max);
+      status.values.push_back(kv);
+      msg.status.push_back(status);
+    }
+  }
+
+private:
+  std::vector<LatencyHistogram> histograms_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_CALL_PROFILER_H
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_CLOCK_OFFSET_ESTIMATOR_H
+#define SCHUNK_SDH_ROS_CLOCK_OFFSET_ESTIMATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <ros/ros.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Maps a wrapping hardware tick counter to ROS time.
+ *
+ * Every sample pairs the tick count of a frame with the ROS time it was received. The receive time is the acquisition
+ * time plus a positive, jittery transport delay, so the samples with the smallest receive-minus-hardware offset are
+ * the ones closest to the truth. The estimator keeps a fixed window of samples and draws a line through the minimum
+ * offsets of its older and its newer half: the line gives the clock offset, its slope the drift of the hardware clock.
+ * A jump of the offset, e.g. after the sensor restarted, discards the window.
+ */
+class ClockOffsetEstimator
+{
+public:
+  /*!
+   * \param tick duration of one hardware tick [s]
+   * \param window number of samples the estimate is based on
+   */
+  explicit ClockOffsetEstimator(double tick = 1e-3, size_t window = 256) :
+      tick_(tick), samples_(window < 2 ? 2 : window)
+  {
+    reset();
+  }
+
+  /// forgets all samples, e.g. after reconnecting
+  void reset()
+  {
+    started_ = false;
+    count_ = 0;
+    next_ = 0;
+    ticks_ = 0;
+    last_ticks_ = 0;
+    base_ = 0.0;
+    offset_ = 0.0;
+    drift_ = 0.0;
+    anchor_ = 0.0;
+    last_hw_ = 0.0;
+  }
+
+  /*!
+   * \brief Adds a sample and estimates the acquisition time of the frame.
+   *
+   * \param ticks hardware timestamp of the frame
+   * \param receive ROS time the frame was received
+   * \return estimated acquisition time, never later than \a receive
+   */
+  ros::Time update(uint32_t ticks, const ros::Time &receive)
+  {
+    const uint32_t step = ticks - last_ticks_;
+    if (!started_ || step > 0x80000000u)  // first sample or counter went backwards
+    {
+      reset();
+      started_ = true;
+      base_ = receive.toSec();
+    }
+    else
+    {
+      ticks_ += step;
+    }
+    last_ticks_ = ticks;
+
+    const double hw = ticks_ * tick_;
+    last_hw_ = hw;
+    const double offset = receive.toSec() - base_ - hw;
+    if (count_ > 0 && std::fabs(offset - offsetAt(hw)) > kJump)
+    {
+      // the hardware clock jumped, start over from this sample
+      reset();
+      return update(ticks, receive);
+    }
+
+    samples_[next_].hw = hw;
+    samples_[next_].offset = offset;
+    next_ = (next_ + 1) % samples_.size();
+    if (count_ < samples_.size())
+      ++count_;
+    fit();
+
+    const double acquisition = base_ + hw + std::min(offsetAt(hw), offset);
+    return ros::Time(acquisition);
+  }
+
+  /// ROS time minus hardware time at the latest sample [s]
+  double offset() const
+  {
+    return base_ + offsetAt(last_hw_);
+  }
+
+  /// drift of ROS time against the hardware clock [s/s]
+  double drift() const
+  {
+    return drift_;
+  }
+
+private:
+  struct Sample
+  {
+    double hw;      // hardware time since the first sample [s]
+    double offset;  // receive time - base_ - hw [s]
+  };
+
+  static constexpr double kJump = 1.0;     // offset change treated as a clock jump [s]
+  static constexpr double kMinSpan = 1.0;  // hardware time between the half minima to estimate drift [s]
+
+  /// estimated offset at hardware time \a hw
+  double offsetAt(double hw) const
+  {
+    return offset_ + drift_ * (hw - anchor_);
+  }
+
+  void fit()
+  {
+    // samples in chronological order start at the oldest one
+    const size_t first = (count_ < samples_.size()) ? 0 : next_;
+    const size_t half = count_ / 2;
+    const Sample *older = 0, *newer = 0;
+    for (size_t k = 0; k < count_; k++)
+    {
+      const Sample &s = samples_[(first + k) % samples_.size()];
+      const Sample *&min = (k < half) ? older : newer;
+      if (!min || s.offset < min->offset)
+        min = &s;
+    }
+    if (older && newer->hw - older->hw >= kMinSpan)
+      drift_ = (newer->offset - older->offset) / (newer->hw - older->hw);
+    offset_ = newer->offset;
+    anchor_ = newer->hw;
+  }
+
+  double tick_;
+  std::vector<Sample> samples_;  // ring buffer
+  size_t count_;
+  size_t next_;
+  bool started_;
+  uint64_t ticks_;       // unwrapped ticks since the first sample
+  uint32_t last_ticks_;
+  double base_;          // receive time of the first sample [s]
+  double offset_;        // offset of the line at anchor_ [s]
+  double drift_;         // slope of the line [s/s]
+  double anchor_;        // [s]
+  double last_hw_;       // hardware time of the latest sample [s]
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_CLOCK_OFFSET_ESTIMATOR_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_COMMAND_MAILBOX_H
+#define SCHUNK_SDH_ROS_COMMAND_MAILBOX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <schunk_sdh_ros/triple_buffer.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Latest-wins command slot between ROS callbacks and the hardware update loop.
+ *
+ * Callbacks post() a command and return immediately, a newer command simply replaces a pending one. The update loop
+ * fetch()es the newest command once per cycle and reports with delivered() when it reached the hardware, which
+ * yields the command-to-wire latency. Each command carries a sequence number, so callers can wait for their
+ * command to be consumed and stale commands can be discarded after a mode switch.
+ *
+ * The consumer side is wait-free. Producers only serialise among themselves for the duration of one copy.
+ */
+template<typename T>
+class CommandMailbox
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Command
+  {
+    uint64_t seq;
+    Clock::time_point stamp;  // time the command was posted
+    T value;
+  };
+
+  CommandMailbox() :
+      posted_seq_(0), discarded_seq_(0), delivered_seq_(0), latency_last_(0.0), latency_max_(0.0)
+  {
+    producer_lock_.clear();
+  }
+
+  /// initializes the command slots, e.g. to preallocate vectors (call before producer and consumer are running)
+  void reset(const T &value)
+  {
+    Command cmd;
+    cmd.seq = 0;
+    cmd.value = value;
+    buffer_.reset(cmd);
+  }
+
+  /*!
+   * \brief Posts a new command, replacing a pending one.
+   *
+   * \return sequence number of the command
+   */
+  uint64_t post(const T &value)
+  {
+    while (producer_lock_.test_and_set(std::memory_order_acquire))
+    {
+    }
+    Command &cmd = buffer_.writeBuffer();
+    cmd.seq = posted_seq_.load(std::memory_order_relaxed) + 1;
+    cmd.stamp = Clock::now();
+    cmd.value = value;
+    posted_seq_.store(cmd.seq, std::memory_order_release);
+    buffer_.publish();
+    const uint64_t seq = cmd.seq;
+    producer_lock_.clear(std::memory_order_release);
+    return seq;
+  }
+
+  /// drops all commands posted so far that have not been fetched yet
+  void discard()
+  {
+    discarded_seq_.store(posted_seq_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  /// true if the command with sequence number \a seq was dropped by discard() before reaching the hardware
+  bool discarded(uint64_t seq) const
+  {
+    return seq <= discarded_seq_.load(std::memory_order_acquire) && seq > deliveredSeq();
+  }
+
+  /*!
+   * \brief Consumer side: fetches the newest pending command.
+   *
+   * \return the command (valid until the next call) or 0 if nothing new was posted
+   */
+  const Command *fetch()
+  {
+    if (!buffer_.update())
+      return 0;
+    const Command &cmd = buffer_.readBuffer();
+    if (cmd.seq <= discarded_seq_.load(std::memory_order_acquire))
+      return 0;
+    return &cmd;
+  }
+
+  /// consumer side: marks a fetched command as written to the hardware
+  void delivered(const Command &cmd)
+  {
+    const double latency = std::chrono::duration<double>(Clock::now() - cmd.stamp).count();
+    latency_last_.store(latency, std::memory_order_relaxed);
+    if (latency > latency_max_.load(std::memory_order_relaxed))
+      latency_max_.store(latency, std::memory_order_relaxed);
+    delivered_seq_.store(cmd.seq, std::memory_order_release);
+  }
+
+  /// sequence number of the last command that reached the hardware
+  uint64_t deliveredSeq() const
+  {
+    return delivered_seq_.load(std::memory_order_acquire);
+  }
+
+  /// command-to-wire latency of the last delivered command [s]
+  double latencyLast() const
+  {
+    return latency_last_.load(std::memory_order_relaxed);
+  }
+
+  /// worst command-to-wire latency since start [s]
+  double latencyMax() const
+  {
+    return latency_max_.load(std::memory_order_relaxed);
+  }
+
+private:
+  TripleBuffer<Command> buffer_;
+  std::atomic_flag producer_lock_;
+  std::atomic<uint64_t> posted_seq_;
+  std::atomic<uint64_t> discarded_seq_;
+  std::atomic<uint64_t> delivered_seq_;
+  std::atomic<double> latency_last_;
+  std::atomic<double> latency_max_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_COMMAND_MAILBOX_H
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_CONTACT_SEGMENTER_H
+#define SCHUNK_SDH_ROS_CONTACT_SEGMENTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <schunk_sdh/dsa.h>
+
+namespace schunk_sdh_ros
+{
+
+/// one connected contact region of a matrix
+struct ContactRegion
+{
+  int matrix;             // SDHLibrary matrix
+  double force;           // [N]
+  double area;            // [mm^2]
+  double cog_x, cog_y;    // centre of pressure [mm]
+  int min_x, min_y, max_x, max_y;  // bounding box [cells], bounds included
+};
+
+/*!
+ * \brief Splits a tactile matrix into 4-connected contact regions.
+ *
+ * Texels above the area threshold are labeled in one raster scan with union-find, a second scan accumulates force,
+ * area, centre of pressure and bounding box per region. Regions whose raw values sum up to less than the force
+ * threshold are dropped, like cDSA::GetContactInfo() does for a whole matrix. All buffers are sized by reserve(), so
+ * segmenting does not allocate.
+ */
+class ContactSegmenter
+{
+public:
+  /// sizes the buffers for matrices of up to \a cells texels
+  void reserve(size_t cells)
+  {
+    labels_.resize(cells);
+    parent_.resize(cells + 1);
+    stats_.resize(cells + 1);
+  }
+
+  /*!
+   * \brief Appends the regions of one matrix.
+   *
+   * \param matrix SDHLibrary matrix, copied into the regions
+   * \param cells_x, cells_y matrix size, at most reserve() texels
+   * \param raw raw texel values, row by row
+   * \param pressure pressure of each texel [Pa]
+   * \param texel_width, texel_height texel size [mm]
+   * \param area_threshold texels above this raw value are in contact
+   * \param force_threshold minimum sum of raw values of a region
+   * \param regions receives the regions
+   */
+  void segment(int matrix, int cells_x, int cells_y, const SDH::cDSA::tTexel *raw, const double *pressure,
+               double texel_width, double texel_height, double area_threshold, double force_threshold,
+               std::vector<ContactRegion> &regions)
+  {
+    // first scan: provisional labels, equivalences in parent_
+    int next = 1;
+    for (int y = 0, i = 0; y < cells_y; y++)
+    {
+      for (int x = 0; x < cells_x; x++, i++)
+      {
+        if (raw[i] <= area_threshold)
+        {
+          labels_[i] = 0;
+          continue;
+        }
+        const int left = (x > 0) ? labels_[i - 1] : 0;
+        const int up = (y > 0) ? labels_[i - cells_x] : 0;
+        if (!left && !up)
+        {
+          parent_[next] = next;
+          labels_[i] = next++;
+        }
+        else if (left && up)
+        {
+          const int a = find(left), b = find(up);
+          parent_[std::max(a, b)] = std::min(a, b);
+          labels_[i] = std::min(a, b);
+        }
+        else
+        {
+          labels_[i] = left ? left : up;
+        }
+      }
+    }
+
+    // second scan: statistics per root label
+    for (int l = 1; l < next; l++)
+      stats_[l] = Stats();
+    for (int y = 0, i = 0; y < cells_y; y++)
+    {
+      for (int x = 0; x < cells_x; x++, i++)
+      {
+        if (!labels_[i])
+          continue;
+        Stats &s = stats_[find(labels_[i])];
+        if (s.cells++ == 0)
+        {
+          s.min_x = s.max_x = x;
+          s.min_y = s.max_y = y;
+        }
+        s.raw += raw[i];
+        s.pressure += pressure[i];
+        s.moment_x += x * raw[i];
+        s.moment_y += y * raw[i];
+        s.min_x = std::min(s.min_x, x);
+        s.max_x = std::max(s.max_x, x);
+        s.min_y = std::min(s.min_y, y);
+        s.max_y = std::max(s.max_y, y);
+      }
+    }
+
+    const double cell_area = texel_width * texel_height;
+    for (int l = 1; l < next; l++)
+    {
+      const Stats &s = stats_[l];
+      if (s.cells == 0 || s.raw < force_threshold)
+        continue;
+      ContactRegion region;
+      region.matrix = matrix;
+      region.force = s.pressure * cell_area * 1e-6;
+      region.area = s.cells * cell_area;
+      region.cog_x = texel_width * s.moment_x / s.raw;
+      region.cog_y = texel_height * s.moment_y / s.raw;
+      region.min_x = s.min_x;
+      region.min_y = s.min_y;
+      region.max_x = s.max_x;
+      region.max_y = s.max_y;
+      regions.push_back(region);
+    }
+  }
+
+private:
+  struct Stats
+  {
+    int cells;
+    double raw, pressure, moment_x, moment_y;
+    int min_x, min_y, max_x, max_y;
+
+    Stats() :
+        cells(0), raw(0.0), pressure(0.0), moment_x(0.0), moment_y(0.0), min_x(0), min_y(0), max_x(0), max_y(0)
+    {
+    }
+  };
+
+  int find(int label)
+  {
+    while (parent_[label] != label)
+    {
+      parent_[label] = parent_[parent_[label]];  // path halving
+      label = parent_[label];
+    }
+    return label;
+  }
+
+  std::vector<int> labels_;  // provisional label of each texel, 0 if not in contact
+  std::vector<int> parent_;  // union-find forest over the labels
+  std::vector<Stats> stats_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_CONTACT_SEGMENTER_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_CYCLE_STATS_H
+#define SCHUNK_SDH_ROS_CYCLE_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include <schunk_sdh_ros/triple_buffer.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Cycle time statistics of a fixed-rate loop.
+ *
+ * The loop thread calls update() once per cycle. Every report period the accumulated window is handed over as a
+ * Summary through a TripleBuffer, so any other thread can read it with latest() without locking.
+ */
+class CycleStats
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Summary
+  {
+    uint64_t cycles;     // total number of cycles since start
+    uint64_t overruns;   // total number of cycles where the work took longer than the nominal period
+    double rate;         // achieved loop rate in the last window [Hz]
+    double period_max;   // longest cycle period in the last window [s]
+    double work_mean;    // mean time spent in the loop body in the last window [s]
+    double work_max;     // longest time spent in the loop body in the last window [s]
+
+    Summary() :
+        cycles(0), overruns(0), rate(0.0), period_max(0.0), work_mean(0.0), work_max(0.0)
+    {
+    }
+  };
+
+  explicit CycleStats(double nominal_period = 0.01, double report_period = 1.0) :
+      nominal_period_(nominal_period), report_period_(report_period), has_last_(false)
+  {
+    resetWindow();
+  }
+
+  void setNominalPeriod(double period)
+  {
+    nominal_period_ = period;
+  }
+
+  /*!
+   * \brief Records one loop cycle.
+   *
+   * \param start time the loop body started
+   * \param end time the loop body finished
+   */
+  void update(const Clock::time_point &start, const Clock::time_point &end)
+  {
+    const double work = std::chrono::duration<double>(end - start).count();
+    ++total_.cycles;
+    if (work > nominal_period_)
+      ++total_.overruns;
+
+    if (has_last_)
+    {
+      const double period = std::chrono::duration<double>(start - last_start_).count();
+      window_period_max_ = std::max(window_period_max_, period);
+      ++window_periods_;
+    }
+    else
+    {
+      window_start_ = start;
+      has_last_ = true;
+    }
+    last_start_ = start;
+
+    ++window_cycles_;
+    window_work_sum_ += work;
+    window_work_max_ = std::max(window_work_max_, work);
+
+    const double elapsed = std::chrono::duration<double>(start - window_start_).count();
+    if (elapsed >= report_period_)
+    {
+      Summary &s = summary_.writeBuffer();
+      s = total_;
+      s.rate = window_periods_ / elapsed;
+      s.period_max = window_period_max_;
+      s.work_mean = window_work_sum_ / window_cycles_;
+      s.work_max = window_work_max_;
+      summary_.publish();
+
+      resetWindow();
+      window_start_ = start;
+    }
+  }
+
+  /// newest published summary, safe to call from any single reader thread
+  const Summary &latest()
+  {
+    summary_.update();
+    return summary_.readBuffer();
+  }
+
+private:
+  void resetWindow()
+  {
+    window_cycles_ = 0;
+    window_periods_ = 0;
+    window_work_sum_ = 0.0;
+    window_work_max_ = 0.0;
+    window_period_max_ = 0.0;
+  }
+
+  double nominal_period_;
+  double report_period_;
+
+  Summary total_;
+  bool has_last_;
+  Clock::time_point last_start_;
+  Clock::time_point window_start_;
+  uint64_t window_cycles_;
+  uint64_t window_periods_;
+  double window_work_sum_;
+  double window_work_max_;
+  double window_period_max_;
+
+  TripleBuffer<Summary> summary_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_CYCLE_STATS_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_DSA_FRAME_H
+#define SCHUNK_SDH_ROS_DSA_FRAME_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Copy of one complete tactile frame, decoupled from the cDSA instance that keeps reading.
+ *
+ * Texels of all matrices are stored back to back in SDHLibrary matrix order, each matrix row by row, which is the
+ * layout of the cDSA frame buffer itself. The layout is only rebuilt when the sensor reports a different geometry, so
+ * in steady state a copy does not allocate.
+ */
+struct DsaFrame
+{
+  ros::Time stamp;       // acquisition time of the frame in ROS time
+  uint32_t timestamp;    // sensor timestamp of the frame
+  uint64_t seq;          // frames read since the reader started, 0 if none
+
+  std::vector<uint16_t> cells_x;   // per matrix
+  std::vector<uint16_t> cells_y;   // per matrix
+  std::vector<float> texel_width;  // per matrix [mm]
+  std::vector<float> texel_height; // per matrix [mm]
+  std::vector<size_t> offset;      // first texel of each matrix, nb_matrices + 1 entries
+  std::vector<int> matrix_index;   // matrix of finger f and part p at 2 * f + p
+  std::vector<SDH::cDSA::tTexel> texels;
+
+  DsaFrame() :
+      timestamp(0), seq(0)
+  {
+  }
+
+  size_t matrices() const
+  {
+    return cells_x.size();
+  }
+
+  /// first texel of matrix \a m, matrix(matrices()) is the end of the last matrix
+  const SDH::cDSA::tTexel *matrix(size_t m) const
+  {
+    return texels.data() + offset[m];
+  }
+};
+
+/*!
+ * \brief Copies the frame last read by cDSA::UpdateFrame().
+ *
+ * \param dsa connected sensor, must not be used by another thread during the copy; any type with the frame and info
+ *            accessors of SDH::cDSA, so tests can replay frames without hardware
+ * \param stamp acquisition time of the frame
+ * \param seq sequence number of the frame
+ * \param frame receives the copy
+ */
+template<typename Sensor>
+inline void copyDsaFrame(Sensor &dsa, const ros::Time &stamp, uint64_t seq, DsaFrame &frame)
+{
+  const int nb_matrices = dsa.GetSensorInfo().nb_matrices;
+  bool layout_changed = static_cast<int>(frame.matrices()) != nb_matrices;
+  for (int m = 0; m < nb_matrices && !layout_changed; m++)
+  {
+    layout_changed = frame.cells_x[m] != dsa.GetMatrixInfo(m).cells_x
+        || frame.cells_y[m] != dsa.GetMatrixInfo(m).cells_y;
+  }
+  if (layout_changed)
+  {
+    frame.cells_x.resize(nb_matrices);
+    frame.cells_y.resize(nb_matrices);
+    frame.texel_width.resize(nb_matrices);
+    frame.texel_height.resize(nb_matrices);
+    frame.offset.assign(1, 0);
+    for (int m = 0; m < nb_matrices; m++)
+    {
+      frame.cells_x[m] = dsa.GetMatrixInfo(m).cells_x;
+      frame.cells_y[m] = dsa.GetMatrixInfo(m).cells_y;
+      frame.texel_width[m] = dsa.GetMatrixInfo(m).texel_width;
+      frame.texel_height[m] = dsa.GetMatrixInfo(m).texel_height;
+      frame.offset.push_back(frame.offset.back() + frame.cells_x[m] * frame.cells_y[m]);
+    }
+    frame.texels.resize(frame.offset.back());
+    frame.matrix_index.resize(6);
+    for (int fi = 0; fi < 3; fi++)
+    {
+      for (int part = 0; part < 2; part++)
+        frame.matrix_index[2 * fi + part] = dsa.GetMatrixIndex(fi, part);
+    }
+  }
+
+  frame.stamp = stamp;
+  frame.timestamp = dsa.GetFrame().timestamp;
+  frame.seq = seq;
+  // the frame buffer has the same layout, so all matrices are one contiguous copy
+  const SDH::cDSA::tTexel *texels = dsa.GetFrame().texel;
+  std::copy(texels, texels + frame.texels.size(), frame.texels.begin());
+}
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_DSA_FRAME_H
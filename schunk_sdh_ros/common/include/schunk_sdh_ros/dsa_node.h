@@ -0,0 +1,904 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_DSA_NODE_H
+#define SCHUNK_SDH_ROS_DSA_NODE_H
+
+// standard includes
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ROS includes
+#include <ros/ros.h>
+
+// ROS message includes
+#include <schunk_sdh/TactileSensor.h>
+#include <schunk_sdh/TactileMatrix.h>
+#include <schunk_sdh/PressureArrayList.h>
+#include <schunk_sdh_ros/ContactInfo.h>
+#include <schunk_sdh_ros/ContactInfoArray.h>
+#include <schunk_sdh_ros/ContactBlobArray.h>
+#include <schunk_sdh_ros/SparseTactileSensor.h>
+#include <schunk_sdh_ros/SlipEvent.h>
+#include <schunk_sdh_ros/GetTactileHistory.h>
+#include <std_msgs/Time.h>
+
+// ROS diagnostic msgs
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/KeyValue.h>
+
+#include <schunk_sdh/dsa.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/bind.hpp>
+
+// package includes
+#include <schunk_sdh_ros/call_profiler.h>
+#include <schunk_sdh_ros/clock_offset_estimator.h>
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/reconnect_backoff.h>
+#include <schunk_sdh_ros/slip_detector.h>
+#include <schunk_sdh_ros/reusable_message.h>
+#include <schunk_sdh_ros/sparse_tactile.h>
+#include <schunk_sdh_ros/stream_gate.h>
+#include <schunk_sdh_ros/tactile_history.h>
+#include <schunk_sdh_ros/tactile_decoder.h>
+
+namespace schunk_sdh_ros
+{
+
+namespace detail
+{
+
+template<typename T>
+bool read_vector(ros::NodeHandle &n_, const std::string &key, std::vector<T> & res)
+{
+  XmlRpc::XmlRpcValue namesXmlRpc;
+  if (!n_.hasParam(key))
+  {
+    return false;
+  }
+
+  n_.getParam(key, namesXmlRpc);
+  /// Resize and assign of values to the vector
+  res.resize(namesXmlRpc.size());
+  for (int i = 0; i < namesXmlRpc.size(); i++)
+  {
+    res[i] = (T)namesXmlRpc[i];
+  }
+  return true;
+}
+
+}  // namespace detail
+
+/*!
+ * \brief Implementation of ROS node for DSA.
+ *
+ * Publishes the tactile frames, pressures, contacts, contact blobs and slip events of the sensor and keeps a history
+ * of the last frames.
+ */
+class DsaNode
+{
+public:
+  /// create a handle for this node, initialize node
+  ros::NodeHandle nh_;
+private:
+  // declaration of topics to publish
+  ros::Publisher topicPub_TactileSensor_;
+  ros::Publisher topicPub_Diagnostics_;
+  ros::Publisher topicPub_ContactInfo_;
+  ros::Publisher topicPub_ContactBlobs_;
+  ros::Publisher topicPub_Pressure_;
+  ros::Publisher topicPub_SparseTactile_;
+  ros::Publisher topicPub_CallStats_;
+  ros::Publisher topicPub_SlipEvents_;
+
+  // topic subscribers
+  ros::Subscriber subFreezeHistory_;
+
+  // service servers
+  ros::ServiceServer srvServer_GetTactileHistory_;
+
+  // actionlib server
+
+  // service clients
+  // --
+
+  // other variables
+  SDH::cDSA *dsa_;
+  SDH::UInt32 last_data_publish_;  // time stamp of last data publishing
+
+  std::string dsadevicestring_;
+  std::string dsadevicetype_;
+  int dsadevicenum_;
+  int maxerror_;  // maximum error count allowed
+
+  bool isDSAInitialized_;
+  int error_counter_;
+  bool polling_;  // try to publish on each response
+  bool poll_pending_;  // polling: a frame was requested and its reply not read yet
+  std::thread poll_thread_;  // polling: requests and reads the frames, the only user of dsa_ then
+  std::atomic<bool> poll_running_;
+  std::mutex frame_mutex_;  // polling: guards the frame state and the connection against the callbacks
+  bool use_rle_;
+  bool debug_;
+  double frequency_, timeout_;
+  int dsa_port_;
+
+  ros::Timer timer_dsa, timer_diag;
+
+  std::vector<int> dsa_reorder_;
+  schunk_sdh_ros::DsaFrame frame_;  // copy of the last decoded frame
+  schunk_sdh_ros::ClockOffsetEstimator clock_;  // sensor timestamps to ROS time
+  ros::Time frame_stamp_;  // estimated acquisition time of the frame last read
+  double frame_latency_last_;  // acquisition to publishing of the last frame [s]
+  double frame_latency_max_;   // since the last diagnostics [s]
+  schunk_sdh_ros::TactileDecoder decoder_;  // derives all outputs from frame_
+  std::vector<SDH::cDSA::sContactInfo> contacts_;  // SDHLibrary matrix order
+  std::vector<schunk_sdh_ros::ContactRegion> regions_;  // connected contact regions of all matrices
+  // published messages, never modified while a subscriber still holds them
+  schunk_sdh_ros::ReusableMessage<schunk_sdh::TactileSensor> tactileMsg_;
+  schunk_sdh_ros::ReusableMessage<schunk_sdh::PressureArrayList> pressureMsg_;
+  schunk_sdh_ros::ReusableMessage<schunk_sdh_ros::SparseTactileSensor> sparseMsg_;
+  schunk_sdh_ros::SparseTactileEncoder sparse_encoder_;  // keyframes and deltas of tactile_data
+  schunk_sdh_ros::ReusableMessage<schunk_sdh_ros::ContactInfoArray> contactMsg_;
+  schunk_sdh_ros::ReusableMessage<schunk_sdh_ros::ContactBlobArray> blobMsg_;
+  // which frames each topic gets, see publishFrame()
+  schunk_sdh_ros::StreamGate tactile_gate_, pressure_gate_, sparse_gate_, contact_gate_, blob_gate_;
+  schunk_sdh_ros::SlipDetector slip_detector_;
+  std::vector<schunk_sdh_ros::Slip> slips_;
+  double slip_latency_last_;  // acquisition to publishing of the last slip event [s]
+  double slip_latency_max_;   // since the last diagnostics [s]
+  schunk_sdh_ros::TactileHistory history_;         // the last frames, see get_tactile_history
+  schunk_sdh_ros::TactileHistory frozen_history_;  // window frozen by freeze_history
+  double freeze_before_, freeze_after_;  // frozen window around the trigger time [s]
+  ros::Time freeze_time_;
+  bool freeze_pending_;  // waiting for the frames after freeze_time_
+  schunk_sdh_ros::CallProfiler profiler_;  // latencies of the hardware calls, published on call_stats
+
+  // connecting runs in the supervisor thread, the members below are guarded by connect_mutex_
+  std::thread supervisor_thread_;
+  std::mutex connect_mutex_;
+  std::condition_variable connect_cond_;
+  bool supervisor_running_;
+  bool reconnect_requested_;
+  SDH::cDSA *connected_dsa_;  // connected by the supervisor, not yet taken over by start()
+  schunk_sdh_ros::ReconnectBackoff backoff_;
+  std::string connect_error_;  // error of the last failed attempt
+public:
+  /*!
+   * \brief Constructor for DsaNode class
+   *
+   * \param nh private node handle, parameters and topics are resolved in its namespace
+   */
+  explicit DsaNode(const ros::NodeHandle &nh = ros::NodeHandle("~")) :
+      nh_(nh), dsa_(0), last_data_publish_(0), isDSAInitialized_(false), error_counter_(0), poll_pending_(false),
+      poll_running_(false),
+      frame_latency_last_(0.0), frame_latency_max_(0.0), slip_latency_last_(0.0), slip_latency_max_(0.0),
+      supervisor_running_(false), reconnect_requested_(false),
+      connected_dsa_(0), freeze_before_(0.0), freeze_after_(0.0), freeze_pending_(false)
+  {
+    topicPub_Diagnostics_ = nh_.advertise < diagnostic_msgs::DiagnosticArray > ("/diagnostics", 1);
+    topicPub_TactileSensor_ = nh_.advertise < schunk_sdh::TactileSensor > ("tactile_data", 1);
+    topicPub_ContactInfo_ = nh_.advertise < schunk_sdh_ros::ContactInfoArray > ("contact_info_array", 1);
+    topicPub_ContactBlobs_ = nh_.advertise < schunk_sdh_ros::ContactBlobArray > ("contact_blobs", 1);
+    topicPub_Pressure_ = nh_.advertise < schunk_sdh::PressureArrayList > ("pressure", 1);
+    topicPub_SparseTactile_ = nh_.advertise < schunk_sdh_ros::SparseTactileSensor > ("tactile_data_sparse", 1);
+    topicPub_CallStats_ = nh_.advertise < diagnostic_msgs::DiagnosticArray > ("call_stats", 1);
+    topicPub_SlipEvents_ = nh_.advertise < schunk_sdh_ros::SlipEvent > ("slip_events", 10);
+    subFreezeHistory_ = nh_.subscribe("freeze_history", 1, &DsaNode::topicCallback_freezeHistory, this);
+    srvServer_GetTactileHistory_ = nh_.advertiseService("get_tactile_history", &DsaNode::srvCallback_GetTactileHistory,
+                                                        this);
+  }
+
+  /*!
+   * \brief Destructor for DsaNode class
+   */
+  ~DsaNode()
+  {
+    stopPolling();
+    stopSupervisor();
+    if (isDSAInitialized_)
+      dsa_->Close();
+    if (dsa_)
+      delete dsa_;
+  }
+
+  void shutdown()
+  {
+    timer_dsa.stop();
+    timer_diag.stop();
+    stopPolling();
+    stopSupervisor();
+    nh_.shutdown();
+  }
+
+  /*!
+   * \brief Initializes node to get parameters, subscribe and publish to topics.
+   */
+  bool init()
+  {
+    // implementation of topics to publish
+
+    nh_.param("dsadevicestring", dsadevicestring_, std::string(""));
+    nh_.param("dsadevicetype", dsadevicetype_, std::string(""));
+    if (dsadevicestring_.empty())
+      return false;
+
+    nh_.param("dsadevicenum", dsadevicenum_, 0);
+    nh_.param("maxerror", maxerror_, 8);
+
+    double publish_frequency, diag_frequency;
+
+    nh_.param("debug", debug_, false);
+    int sparse_keyframe_interval, sparse_threshold;
+    nh_.param("sparse_keyframe_interval", sparse_keyframe_interval, 30);
+    nh_.param("sparse_threshold", sparse_threshold, 0);
+    sparse_encoder_.configure(sparse_keyframe_interval, sparse_threshold);
+    int history_length;
+    nh_.param("history_length", history_length, 90);
+    nh_.param("history_freeze_before", freeze_before_, 0.5);
+    nh_.param("history_freeze_after", freeze_after_, 0.2);
+    history_.setCapacity(std::max(history_length, 0));
+    frozen_history_.setCapacity(std::max(history_length, 0));
+    nh_.param("polling", polling_, false);
+    nh_.param("use_rle", use_rle_, true);
+    nh_.param("diag_frequency", diag_frequency, 5.0);
+    nh_.param("dsaport", dsa_port_, 1300);
+    nh_.param("timeout", timeout_, static_cast<double>(0.04));
+    double reconnect_min_delay, reconnect_max_delay, reconnect_jitter;
+    nh_.param("reconnect_min_delay", reconnect_min_delay, 0.1);
+    nh_.param("reconnect_max_delay", reconnect_max_delay, 5.0);
+    nh_.param("reconnect_jitter", reconnect_jitter, 0.2);
+    backoff_.configure(reconnect_min_delay, reconnect_max_delay, reconnect_jitter);
+    frequency_ = 30.0;
+    if (polling_)
+      nh_.param("poll_frequency", frequency_, 5.0);  // 0 polls as fast as the sensor replies
+    nh_.param("publish_frequency", publish_frequency, 0.0);
+
+    // publish_frequency still caps the matrix streams, contacts follow every frame unless configured otherwise
+    tactile_gate_.load(nh_, "tactile_data", publish_frequency);
+    pressure_gate_.load(nh_, "pressure", publish_frequency);
+    sparse_gate_.load(nh_, "tactile_data_sparse", publish_frequency);
+    contact_gate_.load(nh_, "contact_info_array", 0.0);
+    blob_gate_.load(nh_, "contact_blobs", 0.0);
+
+    if (polling_)
+    {
+      poll_running_ = true;
+      poll_thread_ = std::thread(&DsaNode::pollLoop, this);
+    }
+    else
+    {
+      timer_dsa = nh_.createTimer(ros::Rate(frequency_ * 2.0).expectedCycleTime(),
+                                  boost::bind(&DsaNode::readDsaFrame, this));
+    }
+
+    timer_diag = nh_.createTimer(ros::Rate(diag_frequency).expectedCycleTime(),
+                                 boost::bind(&DsaNode::publishDiagnostics, this));
+
+    if (!detail::read_vector(nh_, "dsa_reorder", dsa_reorder_))
+    {
+      dsa_reorder_.resize(6);
+      dsa_reorder_[0] = 2;  // t1
+      dsa_reorder_[1] = 3;  // t2
+      dsa_reorder_[2] = 4;  // f11
+      dsa_reorder_[3] = 5;  // f12
+      dsa_reorder_[4] = 0;  // f21
+      dsa_reorder_[5] = 1;  // f22
+    }
+    decoder_.setReorder(dsa_reorder_);
+
+    double calib_pressure, calib_voltage, contact_area_threshold, contact_force_threshold;
+    nh_.param("dsa_calib_pressure", calib_pressure, 0.000473); // unit: N/(mm*mm)
+    nh_.param("dsa_calib_voltage", calib_voltage, 592.1);      // unit: mV
+    nh_.param("contact_area_cell_threshold", contact_area_threshold, 10.0);
+    nh_.param("contact_force_cell_threshold", contact_force_threshold, 10.0);
+    decoder_.setContactThresholds(contact_area_threshold, contact_force_threshold);
+    double slip_velocity_threshold, slip_change_rate_threshold;
+    int slip_min_frames;
+    nh_.param("slip_velocity_threshold", slip_velocity_threshold, 20.0);       // unit: mm/s
+    nh_.param("slip_change_rate_threshold", slip_change_rate_threshold, 3.0);  // unit: 1/s
+    nh_.param("slip_min_frames", slip_min_frames, 2);
+    slip_detector_.setThresholds(slip_velocity_threshold, slip_change_rate_threshold, slip_min_frames);
+    std::string calibration_error;
+    if (!decoder_.loadCalibration(nh_, "dsa_calibration", calib_pressure / calib_voltage * 1e6, calibration_error))
+    {
+      ROS_ERROR("Parameter dsa_calibration invalid (%s)", calibration_error.c_str());
+      return false;
+    }
+
+    return true;
+  }
+  bool stop()
+  {
+    if (dsa_)
+    {
+      if (isDSAInitialized_)
+        dsa_->Close();
+      delete dsa_;
+    }
+    dsa_ = 0;
+    isDSAInitialized_ = false;
+    return true;
+  }
+
+  /*!
+   * \brief Takes over the connection of the supervisor, or asks it to connect.
+   *
+   * Never blocks: constructing cDSA waits for the whole connect timeout while the sensor is unreachable, so this
+   * happens in the supervisor thread and the timers keep running in the meantime.
+   *
+   * \return true if the sensor is connected
+   */
+  bool start()
+  {
+    if (isDSAInitialized_)
+      return true;
+
+    std::lock_guard<std::mutex> lock(connect_mutex_);
+    if (connected_dsa_)
+    {
+      dsa_ = connected_dsa_;
+      connected_dsa_ = 0;
+      error_counter_ = 0;
+      clock_.reset();
+      poll_pending_ = polling_;  // SetFramerate(0) requested the first frame
+      isDSAInitialized_ = true;
+      ROS_INFO("DSA Tactile Sensors on device %s connected", dsadevicestring_.c_str());
+      return true;
+    }
+    if (!supervisor_thread_.joinable())
+    {
+      supervisor_running_ = true;
+      supervisor_thread_ = std::thread(&DsaNode::superviseConnection, this);
+    }
+    reconnect_requested_ = true;
+    connect_cond_.notify_one();
+    return false;
+  }
+
+  /// drops the connection and starts connecting again right away
+  void reconnect()
+  {
+    stop();
+    start();
+  }
+
+  void readDsaFrame()
+  {
+    if (debug_)
+      ROS_DEBUG("readDsaFrame");
+
+    if (isDSAInitialized_)
+    {
+      try
+      {
+        SDH::UInt32 last_time;
+        last_time = dsa_->GetFrame().timestamp;
+        {
+          schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_DSA_UPDATE_FRAME);
+          dsa_->UpdateFrame();
+        }
+        processFrame(last_time, ros::Time::now());
+      }
+      catch (SDH::cSDHLibraryException* e)
+      {
+        ROS_ERROR("An exception was caught: %s", e->what());
+        delete e;
+        ++error_counter_;
+      }
+      if (error_counter_ > maxerror_)
+        reconnect();
+    }
+    else
+    {
+      start();
+    }
+  }
+
+  /// stamps and publishes the frame just read, if it is a new one
+  void processFrame(SDH::UInt32 last_time, const ros::Time &received)
+  {
+    if (last_time != dsa_->GetFrame().timestamp)
+    {
+      // new data
+      frame_stamp_ = clock_.update(dsa_->GetFrame().timestamp, received);
+      if (error_counter_ > 0)
+        --error_counter_;
+      publishFrame();
+    }
+  }
+
+  /*!
+   * \brief Body of the poll thread.
+   *
+   * Keeps one request in flight: the next frame is requested as soon as the reply to the previous one was read,
+   * before that frame is decoded and published, so the sensor acquires and transmits while the node processes. Each
+   * reply is read as soon as it arrives and stamped at its receive time. With a poll_frequency the requests follow its
+   * schedule, a request that is not due yet when a reply arrives goes out at its slot; 0 polls back to back.
+   *
+   * The poll thread is the only user of dsa_. frame_mutex_ is held while a frame is processed or the connection
+   * changes, never while waiting for the sensor.
+   */
+  void pollLoop()
+  {
+    const double period = frequency_ > 0.0 ? 1.0 / frequency_ : 0.0;
+    ros::Time next_request = ros::Time::now();
+    while (poll_running_ && ros::ok())
+    {
+      bool connected;
+      {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        connected = start();
+      }
+      if (!connected)
+      {
+        ros::Duration(0.1).sleep();  // the supervisor connects in the meantime
+        continue;
+      }
+      if (debug_)
+        ROS_DEBUG("pollDsa");
+
+      bool failed = false;
+      if (!poll_pending_)
+      {
+        const double wait = (next_request - ros::Time::now()).toSec();
+        if (period > 0.0 && wait > 0.0)
+          ros::Duration(wait).sleep();
+        failed = !requestFrame(period, next_request);
+      }
+
+      // the reply is read as soon as it arrives, without holding frame_mutex_
+      SDH::UInt32 last_time = 0;
+      bool read = false;
+      ros::Time received;
+      if (!failed)
+      {
+        try
+        {
+          last_time = dsa_->GetFrame().timestamp;
+          {
+            schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_DSA_UPDATE_FRAME);
+            dsa_->UpdateFrame();
+          }
+          received = ros::Time::now();
+          read = true;
+        }
+        catch (SDH::cSDHLibraryException* e)
+        {
+          ROS_ERROR("An exception was caught: %s", e->what());
+          delete e;
+          failed = true;
+        }
+        poll_pending_ = false;  // a lost reply is requested again
+      }
+      // the next frame is acquired while this one is processed, dsa_ keeps this one until the next UpdateFrame()
+      if (read && (period <= 0.0 || received >= next_request))
+        failed = !requestFrame(period, next_request);
+
+      std::lock_guard<std::mutex> lock(frame_mutex_);
+      if (read)
+        processFrame(last_time, received);
+      if (failed)
+        ++error_counter_;
+      if (error_counter_ > maxerror_)
+        reconnect();
+    }
+  }
+
+  /*!
+   * \brief Requests a single frame and advances the request schedule.
+   *
+   * \param period request period [s], 0 if unpaced
+   * \param next_request slot of the next request, behind schedule it restarts from now
+   * \return false if the request failed
+   */
+  bool requestFrame(double period, ros::Time &next_request)
+  {
+    try
+    {
+      schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_DSA_SET_FRAMERATE);
+      dsa_->SetFramerate(0, use_rle_);
+    }
+    catch (SDH::cSDHLibraryException* e)
+    {
+      ROS_ERROR("An exception was caught: %s", e->what());
+      delete e;
+      return false;
+    }
+    poll_pending_ = true;
+    const ros::Time now = ros::Time::now();
+    next_request = ((now - next_request).toSec() > period) ? now + ros::Duration(period)
+                                                           : next_request + ros::Duration(period);
+    return true;
+  }
+
+  void stopPolling()
+  {
+    poll_running_ = false;
+    if (poll_thread_.joinable())
+      poll_thread_.join();
+  }
+
+  /*!
+   * \brief Publishes the current frame of the sensor on every topic that is due.
+   *
+   * Each topic has its own StreamGate, so e.g. contacts can follow every frame while the matrices are published at a
+   * few Hz. Topics without subscribers are skipped, and nothing is copied or decoded if no topic is due.
+   */
+  void publishFrame()
+  {
+    if (debug_)
+      ROS_DEBUG("publishFrame %ul %ul", dsa_->GetFrame().timestamp, last_data_publish_);
+    if (!isDSAInitialized_ || dsa_->GetFrame().timestamp == last_data_publish_)
+      return;  // no new frame available
+    last_data_publish_ = dsa_->GetFrame().timestamp;
+
+    if (history_.capacity() > 0)
+    {
+      copyFrame();
+      history_.record(frame_);
+      if (freeze_pending_ && frame_.stamp >= freeze_time_ + ros::Duration(freeze_after_))
+        freezeHistory();
+    }
+
+    const uint32_t sparse_subscribers = topicPub_SparseTactile_.getNumSubscribers();
+    if (sparse_subscribers == 0)
+      sparse_encoder_.reset();  // a new subscriber starts with a keyframe
+    const bool tactile = tactile_gate_.due(frame_stamp_, topicPub_TactileSensor_.getNumSubscribers());
+    const bool sparse = sparse_gate_.due(frame_stamp_, sparse_subscribers);
+    const bool pressure = pressure_gate_.due(frame_stamp_, topicPub_Pressure_.getNumSubscribers());
+    const bool contact = contact_gate_.due(frame_stamp_, topicPub_ContactInfo_.getNumSubscribers());
+    const bool blobs = blob_gate_.due(frame_stamp_, topicPub_ContactBlobs_.getNumSubscribers());
+    // slip needs every frame, it is never decimated
+    const bool slip = topicPub_SlipEvents_.getNumSubscribers() > 0;
+    if (!slip)
+      slip_detector_.reset();
+    if (!tactile && !sparse && !pressure && !contact && !blobs && !slip)
+      return;
+
+    ROS_ASSERT(static_cast<size_t>(dsa_->GetSensorInfo().nb_matrices) == dsa_reorder_.size());
+    decodeFrame(tactile || sparse, pressure, contact || slip, blobs);
+
+    if (slip)
+      publishSlipEvents();  // first, it is the most urgent output
+
+    if (tactile)
+      topicPub_TactileSensor_.publish(tactileMsg_.current());
+    if (pressure)
+      topicPub_Pressure_.publish(pressureMsg_.current());
+    if (sparse)
+    {
+      // sparse keyframes and deltas
+      boost::shared_ptr<schunk_sdh_ros::SparseTactileSensor> &msg = sparseMsg_.acquire();
+      sparse_encoder_.encode(*tactileMsg_.current(), *msg);
+      topicPub_SparseTactile_.publish(schunk_sdh_ros::SparseTactileSensorConstPtr(msg));
+    }
+    if (contact)
+      publishContactInfo();
+    if (blobs)
+      publishContactBlobs();
+
+    frame_latency_last_ = (ros::Time::now() - frame_.stamp).toSec();
+    frame_latency_max_ = std::max(frame_latency_max_, frame_latency_last_);
+  }
+
+  /// compares the frame with the previous one, publishes one event per slipping matrix
+  void publishSlipEvents()
+  {
+    slip_detector_.update(frame_, contacts_, slips_);
+    for (size_t k = 0; k < slips_.size(); k++)
+    {
+      const int matrix_id = decoder_.messageIndex(slips_[k].matrix);
+      if (matrix_id < 0)
+        continue;
+      schunk_sdh_ros::SlipEventPtr msg(new schunk_sdh_ros::SlipEvent());
+      msg->header.stamp = frame_.stamp;
+      msg->timestamp = frame_.timestamp;
+      msg->matrix_id = matrix_id;
+      msg->onset = slips_[k].onset;
+      msg->x_velocity = slips_[k].x_velocity;
+      msg->y_velocity = slips_[k].y_velocity;
+      msg->change_rate = slips_[k].change_rate;
+      topicPub_SlipEvents_.publish(schunk_sdh_ros::SlipEventConstPtr(msg));
+      slip_latency_last_ = (ros::Time::now() - frame_.stamp).toSec();
+      slip_latency_max_ = std::max(slip_latency_max_, slip_latency_last_);
+    }
+  }
+
+  void publishContactInfo()
+  {
+    boost::shared_ptr<schunk_sdh_ros::ContactInfoArray> &msg = contactMsg_.acquire();
+    msg->header.stamp = frame_.stamp;
+    msg->contact_info.resize(dsa_reorder_.size());
+    for (unsigned int i = 0; i < dsa_reorder_.size(); i++)
+    {
+      const SDH::cDSA::sContactInfo &sdh_contact_info = contacts_[dsa_reorder_[i]];
+      schunk_sdh_ros::ContactInfo &cf = msg->contact_info[i];
+      cf.matrix_id = i;
+      cf.force = sdh_contact_info.force;
+      cf.x_center = sdh_contact_info.cog_x;
+      cf.y_center = sdh_contact_info.cog_y;
+      cf.contact_area = sdh_contact_info.area;
+      cf.in_contact =  (cf.force > 0) ? true : false;
+    }
+    // publish matrix
+    topicPub_ContactInfo_.publish(schunk_sdh_ros::ContactInfoArrayConstPtr(msg));
+  }
+
+  /// every connected contact region, matrices in the order of tactile_data
+  void publishContactBlobs()
+  {
+    boost::shared_ptr<schunk_sdh_ros::ContactBlobArray> &blobs = blobMsg_.acquire();
+    blobs->header.stamp = frame_.stamp;
+    blobs->blobs.clear();
+    for (size_t k = 0; k < regions_.size(); k++)
+    {
+      const schunk_sdh_ros::ContactRegion &region = regions_[k];
+      const int matrix_id = decoder_.messageIndex(region.matrix);
+      if (matrix_id < 0)
+        continue;
+      blobs->blobs.resize(blobs->blobs.size() + 1);
+      schunk_sdh_ros::ContactBlob &blob = blobs->blobs.back();
+      blob.matrix_id = matrix_id;
+      blob.force = region.force;
+      blob.contact_area = region.area;
+      blob.x_center = region.cog_x;
+      blob.y_center = region.cog_y;
+      blob.min_x = region.min_x;
+      blob.min_y = region.min_y;
+      blob.max_x = region.max_x;
+      blob.max_y = region.max_y;
+    }
+    topicPub_ContactBlobs_.publish(schunk_sdh_ros::ContactBlobArrayConstPtr(blobs));
+  }
+
+  /*!
+   * \brief Decodes the current frame of the sensor into the requested outputs.
+   *
+   * All outputs are stamped with the acquisition time estimated from the sensor timestamp.
+   * The frame is copied and decoded only once per sensor timestamp, in one pass for all requested outputs. The
+   * messages are only reused once all subscribers, including intra-process ones, released them.
+   */
+  void decodeFrame(bool tactile, bool pressure, bool contacts, bool regions)
+  {
+    copyFrame();
+    if (!decoder_.isNew(frame_))
+      return;
+    decoder_.decode(frame_, tactile ? tactileMsg_.acquire().get() : 0, pressure ? pressureMsg_.acquire().get() : 0,
+                    contacts ? &contacts_ : 0, regions ? &regions_ : 0);
+  }
+  /// copies the current frame of the sensor into frame_, once per sensor timestamp
+  void copyFrame()
+  {
+    if (frame_.seq == 0 || dsa_->GetFrame().timestamp != frame_.timestamp)
+      schunk_sdh_ros::copyDsaFrame(*dsa_, frame_stamp_, frame_.seq + 1, frame_);
+  }
+
+  /*!
+   * \brief Freezes the frames around the given acquisition time, zero for the newest frame.
+   *
+   * The window reaches from history_freeze_before before to history_freeze_after after the trigger time. It is copied
+   * as soon as the frames after the trigger time were recorded and stays available until the next trigger.
+   */
+  void topicCallback_freezeHistory(const std_msgs::TimeConstPtr &msg)
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    freeze_time_ = msg->data.isZero() ? history_.newest() : msg->data;
+    freeze_pending_ = true;
+    if (history_.newest() >= freeze_time_ + ros::Duration(freeze_after_))
+      freezeHistory();
+  }
+
+  void freezeHistory()
+  {
+    freeze_pending_ = false;
+    const ros::Time start = (freeze_time_.toSec() > freeze_before_) ? freeze_time_ - ros::Duration(freeze_before_)
+                                                                     : ros::Time();
+    const size_t frames = history_.copyWindow(start, freeze_time_ + ros::Duration(freeze_after_), frozen_history_);
+    ROS_INFO("Froze %u tactile frames around %f", static_cast<unsigned int>(frames), freeze_time_.toSec());
+  }
+
+  bool srvCallback_GetTactileHistory(schunk_sdh_ros::GetTactileHistory::Request &req,
+                                     schunk_sdh_ros::GetTactileHistory::Response &res)
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    if (req.frozen && freeze_pending_)
+    {
+      res.success = false;
+      res.message = "frozen window is still being recorded";
+      return true;
+    }
+    const schunk_sdh_ros::TactileHistory &history = req.frozen ? frozen_history_ : history_;
+    const size_t frames = history.extract(req.start, req.end, dsa_reorder_, res);
+    res.success = frames > 0;
+    res.message = boost::lexical_cast < std::string > (frames) + " frames";
+    return true;
+  }
+
+  /*!
+   * \brief Body of the supervisor thread.
+   *
+   * Connects whenever start() asks for it and hands the connected sensor over to start(). The first attempt is
+   * immediate, so a short outage costs a single connect; failed attempts are retried with exponential backoff.
+   */
+  void superviseConnection()
+  {
+    std::unique_lock<std::mutex> lock(connect_mutex_);
+    while (supervisor_running_)
+    {
+      if (!reconnect_requested_ || connected_dsa_)
+      {
+        connect_cond_.wait(lock);
+        continue;
+      }
+      const double delay = backoff_.next();
+      if (delay > 0.0 && connect_cond_.wait_for(lock, std::chrono::duration<double>(delay),
+                                                [this] { return !supervisor_running_; }))
+        break;
+
+      lock.unlock();
+      std::string error;
+      SDH::cDSA *dsa = connect(error);
+      lock.lock();
+      if (dsa)
+      {
+        connected_dsa_ = dsa;
+        reconnect_requested_ = false;
+        backoff_.reset();
+        connect_error_.clear();
+      }
+      else
+      {
+        connect_error_ = error;
+      }
+    }
+  }
+
+  /// opens the sensor and starts the acquisition, 0 on failure
+  SDH::cDSA *connect(std::string &error)
+  {
+    SDH::cDSA *dsa = 0;
+    try
+    {
+      if (dsadevicetype_.compare("TCP") == 0)
+      {
+        ROS_INFO("Initializins TCP for DSA Tactile Sensors on device %s", dsadevicestring_.c_str());
+        dsa = new SDH::cDSA(0, dsadevicestring_.c_str(), dsa_port_, timeout_);
+      }
+      else
+      {
+        dsa = new SDH::cDSA(0, dsadevicenum_, dsadevicestring_.c_str());
+        ROS_INFO("Initialized RS232 for DSA Tactile Sensors on device %s", dsadevicestring_.c_str());
+      }
+      if (!polling_)
+        dsa->SetFramerate(frequency_, use_rle_);
+      else
+        dsa->SetFramerate(0, use_rle_);
+      return dsa;
+    }
+    catch (SDH::cSDHLibraryException* e)
+    {
+      ROS_ERROR("An exception was caught: %s", e->what());
+      error = e->what();
+      delete e;
+      delete dsa;
+      return 0;
+    }
+  }
+
+  void stopSupervisor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(connect_mutex_);
+      supervisor_running_ = false;
+    }
+    connect_cond_.notify_one();
+    if (supervisor_thread_.joinable())
+      supervisor_thread_.join();
+    if (connected_dsa_)
+    {
+      connected_dsa_->Close();
+      delete connected_dsa_;
+      connected_dsa_ = 0;
+    }
+  }
+
+  void publishDiagnostics()
+  {
+    std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+    // publishing diagnotic messages
+    diagnostic_msgs::DiagnosticArray diagnostics;
+    diagnostics.status.resize(1);
+    diagnostics.status[0].name = nh_.getNamespace();
+    diagnostics.status[0].values.resize(1);
+    diagnostics.status[0].values[0].key = "error_count";
+    diagnostics.status[0].values[0].value = boost::lexical_cast < std::string > (error_counter_);
+    diagnostic_msgs::KeyValue kv;
+    kv.key = "frame_latency_last";
+    kv.value = boost::lexical_cast < std::string > (frame_latency_last_);
+    diagnostics.status[0].values.push_back(kv);
+    kv.key = "frame_latency_max";
+    kv.value = boost::lexical_cast < std::string > (frame_latency_max_);
+    diagnostics.status[0].values.push_back(kv);
+    kv.key = "slip_latency_last";
+    kv.value = boost::lexical_cast < std::string > (slip_latency_last_);
+    diagnostics.status[0].values.push_back(kv);
+    kv.key = "slip_latency_max";
+    kv.value = boost::lexical_cast < std::string > (slip_latency_max_);
+    diagnostics.status[0].values.push_back(kv);
+    kv.key = "clock_offset";
+    kv.value = boost::lexical_cast < std::string > (clock_.offset());
+    diagnostics.status[0].values.push_back(kv);
+    kv.key = "clock_drift";
+    kv.value = boost::lexical_cast < std::string > (clock_.drift());
+    diagnostics.status[0].values.push_back(kv);
+    frame_latency_max_ = 0.0;
+    slip_latency_max_ = 0.0;
+
+    // set data to diagnostics
+    if (isDSAInitialized_)
+    {
+      diagnostics.status[0].level = 0;
+      diagnostics.status[0].message = "DSA tactile sensing initialized and running";
+    }
+    else
+    {
+      // the publishers stay advertised while the supervisor reconnects
+      std::lock_guard<std::mutex> lock(connect_mutex_);
+      kv.key = "reconnect_attempts";
+      kv.value = boost::lexical_cast < std::string > (backoff_.attempts());
+      diagnostics.status[0].values.push_back(kv);
+      kv.key = "reconnect_error";
+      kv.value = connect_error_;
+      diagnostics.status[0].values.push_back(kv);
+      if (error_counter_ == 0 && backoff_.attempts() <= 1)
+      {
+        diagnostics.status[0].level = 1;
+        diagnostics.status[0].message = "DSA not initialized, connecting";
+      }
+      else
+      {
+        diagnostics.status[0].level = 2;
+        diagnostics.status[0].message = (error_counter_ > maxerror_) ? "DSA exceeded eror count, reconnecting"
+                                                                      : "DSA reconnecting";
+      }
+    }
+    // publish diagnostic message
+    topicPub_Diagnostics_.publish(diagnostics);
+    if (debug_)
+      ROS_DEBUG_STREAM("publishDiagnostics " << diagnostics);
+
+    // latencies of the hardware calls since the last report
+    diagnostic_msgs::DiagnosticArray call_stats;
+    profiler_.summarize(nh_.getNamespace() + "/", call_stats);
+    topicPub_CallStats_.publish(call_stats);
+  }
+};
+// DsaNode
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_DSA_NODE_H
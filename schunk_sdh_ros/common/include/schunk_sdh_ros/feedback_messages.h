@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_FEEDBACK_MESSAGES_H
+#define SCHUNK_SDH_ROS_FEEDBACK_MESSAGES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <sensor_msgs/JointState.h>
+#include <control_msgs/JointTrajectoryControllerState.h>
+#include <schunk_sdh/TemperatureArray.h>
+
+#include <schunk_sdh_ros/axis_snapshot.h>
+#include <schunk_sdh_ros/joint_mapping.h>
+#include <schunk_sdh_ros/reusable_message.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Joint state, mimic joint state, controller state and temperature messages of the SDH nodes.
+ *
+ * The messages are filled from an AxisSnapshot on every cycle and published with the accessors afterwards. They are
+ * ReusableMessage instances, so filling does not allocate as long as nobody holds on to a published message.
+ */
+class FeedbackMessages
+{
+public:
+  FeedbackMessages() :
+      temperature_count_(0)
+  {
+  }
+
+  /*!
+   * \brief Builds the message prototypes, names and sizes never change afterwards.
+   *
+   * \param mapping joint order <-> axis order, initialized with \a joint_names
+   * \param joint_names joint names in ROS order
+   * \param temperature_names names of the temperatures of a snapshot
+   */
+  void reset(const JointMapping &mapping, const std::vector<std::string> &joint_names,
+             const std::vector<std::string> &temperature_names)
+  {
+    mapping_ = mapping;
+    const size_t dof = joint_names.size();
+
+    sensor_msgs::JointState joint_state;
+    joint_state.name = joint_names;
+    joint_state.position.resize(dof);
+    joint_state.velocity.resize(dof);
+    joint_state.effort.resize(dof);
+    joint_state_.reset(joint_state);
+    joint_state.name.assign(1, mapping.mimicJointName());
+    joint_state.position.resize(1);
+    joint_state.velocity.resize(1);
+    joint_state.effort.clear();
+    mimic_joint_.reset(joint_state);
+
+    control_msgs::JointTrajectoryControllerState controller_state;
+    controller_state.joint_names = joint_names;
+    controller_state.desired.positions.resize(dof);
+    controller_state.desired.velocities.resize(dof);
+    controller_state.actual.positions.resize(dof);
+    controller_state.actual.velocities.resize(dof);
+    controller_state.error.positions.resize(dof);
+    controller_state.error.velocities.resize(dof);
+    controller_state_.reset(controller_state);
+
+    schunk_sdh::TemperatureArray temperature_array;
+    temperature_array.name = temperature_names;
+    temperature_array.temperature.resize(temperature_names.size());
+    temperatures_.reset(temperature_array);
+    temperature_count_ = temperature_names.size();
+  }
+
+  /*!
+   * \brief Fills joint state, mimic joint state and controller state from the angles and velocities of a snapshot.
+   *
+   * \param snapshot feedback read from the hand, angles and velocities of all axes
+   * \param target_angles desired angles in axis order [deg], the desired positions are kept if the size does not fit
+   */
+  void fillJointStates(const AxisSnapshot &snapshot, const std::vector<double> &target_angles)
+  {
+    // joint_state message, names are set by the prototype
+    const boost::shared_ptr<sensor_msgs::JointState> &msg = joint_state_.acquire();
+    msg->header.stamp = snapshot.stamp;
+    mapping_.axesToJointsRad(snapshot.angles.data(), msg->position.data());
+    mapping_.axesToJointsRad(snapshot.velocities.data(), msg->velocity.data());
+
+    // the robot_state_publisher doesn't know about the mimic joint, so the coupled joint is published separately
+    const boost::shared_ptr<sensor_msgs::JointState> &mimic = mimic_joint_.acquire();
+    mimic->header.stamp = snapshot.stamp;
+    const int knuckle = mapping_.jointOfAxis(0);
+    mimic->position[0] = msg->position[knuckle];  // knuckle_joint = finger_21_joint
+    mimic->velocity[0] = msg->velocity[knuckle];  // knuckle_joint = finger_21_joint
+
+    // controller state, joint names are set by the prototype, desired velocities are all zero
+    const boost::shared_ptr<control_msgs::JointTrajectoryControllerState> &controller = controller_state_.acquire();
+    controller->header.stamp = snapshot.stamp;
+    if (target_angles.size() == mapping_.size())
+      mapping_.axesToJointsRad(target_angles.data(), controller->desired.positions.data());
+    controller->actual.positions = msg->position;
+    controller->actual.velocities = msg->velocity;
+    // error, calculated out of desired and actual values
+    for (size_t i = 0; i < mapping_.size(); i++)
+    {
+      controller->error.positions[i] = controller->desired.positions[i] - controller->actual.positions[i];
+      controller->error.velocities[i] = controller->desired.velocities[i] - controller->actual.velocities[i];
+    }
+  }
+
+  /*!
+   * \brief Fills the temperature message from a snapshot.
+   *
+   * \param snapshot feedback read from the hand
+   * \return false if the number of temperatures does not match the names, the message is untouched then
+   */
+  bool fillTemperatures(const AxisSnapshot &snapshot)
+  {
+    if (snapshot.temperatures.size() != temperature_count_)
+      return false;
+    const boost::shared_ptr<schunk_sdh::TemperatureArray> &msg = temperatures_.acquire();
+    msg->header.stamp = snapshot.stamp;
+    msg->temperature = snapshot.temperatures;
+    return true;
+  }
+
+  /// instances of the last fill, to be published
+  sensor_msgs::JointStateConstPtr jointState() const
+  {
+    return joint_state_.current();
+  }
+
+  sensor_msgs::JointStateConstPtr mimicJoint() const
+  {
+    return mimic_joint_.current();
+  }
+
+  control_msgs::JointTrajectoryControllerStateConstPtr controllerState() const
+  {
+    return controller_state_.current();
+  }
+
+  schunk_sdh::TemperatureArrayConstPtr temperatures() const
+  {
+    return temperatures_.current();
+  }
+
+  /// message instances allocated so far, stays constant in steady state
+  uint64_t allocations() const
+  {
+    return joint_state_.allocations() + mimic_joint_.allocations() + controller_state_.allocations()
+        + temperatures_.allocations();
+  }
+
+private:
+  JointMapping mapping_;
+  ReusableMessage<sensor_msgs::JointState> joint_state_;
+  ReusableMessage<sensor_msgs::JointState> mimic_joint_;
+  ReusableMessage<control_msgs::JointTrajectoryControllerState> controller_state_;
+  ReusableMessage<schunk_sdh::TemperatureArray> temperatures_;
+  size_t temperature_count_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_FEEDBACK_MESSAGES_H
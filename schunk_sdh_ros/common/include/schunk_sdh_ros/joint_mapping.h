@@ -0,0 +1,210 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_JOINT_MAPPING_H
+#define SCHUNK_SDH_ROS_JOINT_MAPPING_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace schunk_sdh_ros
+{
+
+/// degrees per radian
+const double kDegPerRad = 180.0 / 3.14159265358979323846;
+/// radians per degree
+const double kRadPerDeg = 3.14159265358979323846 / 180.0;
+
+/*!
+ * \brief Permutation between the ROS joint order and the SDH axis order.
+ *
+ * The table is built once from the configured joint names. Joints are identified by their name suffix, so any
+ * prefix ("sdh_", "schunk_right_", ...) and any order of the joint_names parameter works. All conversions are
+ * split into a gather through the table and a contiguous scaling loop the compiler can vectorize.
+ */
+class JointMapping
+{
+public:
+  /*!
+   * \brief Builds the permutation table.
+   *
+   * \param joint_names joint names in ROS order, one per SDH axis
+   * \param error receives a description if the names cannot be mapped
+   * \return true on success
+   */
+  bool init(const std::vector<std::string> &joint_names, std::string &error)
+  {
+    const std::vector<std::string> &suffixes = axisSuffixes();
+    joint_names_ = joint_names;
+    axis_of_joint_.assign(joint_names.size(), -1);
+    joint_of_axis_.assign(suffixes.size(), -1);
+    if (joint_names.size() != suffixes.size())
+    {
+      error = "expected " + std::to_string(suffixes.size()) + " joint names, got "
+          + std::to_string(joint_names.size());
+      return false;
+    }
+    for (size_t j = 0; j < joint_names.size(); j++)
+    {
+      for (size_t a = 0; a < suffixes.size(); a++)
+      {
+        if (endsWith(joint_names[j], suffixes[a]))
+        {
+          if (joint_of_axis_[a] >= 0)
+          {
+            error = "joints " + joint_names[joint_of_axis_[a]] + " and " + joint_names[j] + " map to the same axis";
+            return false;
+          }
+          axis_of_joint_[j] = a;
+          joint_of_axis_[a] = j;
+          break;
+        }
+      }
+      if (axis_of_joint_[j] < 0)
+      {
+        error = "joint " + joint_names[j] + " does not match any SDH axis";
+        return false;
+      }
+    }
+    const std::string &knuckle = joint_names[joint_of_axis_[0]];
+    mimic_joint_name_ = knuckle.substr(0, knuckle.size() - suffixes[0].size()) + "finger_21_joint";
+    return true;
+  }
+
+  size_t size() const
+  {
+    return joint_of_axis_.size();
+  }
+
+  /// SDH axis of ROS joint \a joint
+  int axisOfJoint(size_t joint) const
+  {
+    return axis_of_joint_[joint];
+  }
+
+  /// ROS joint of SDH axis \a axis
+  int jointOfAxis(size_t axis) const
+  {
+    return joint_of_axis_[axis];
+  }
+
+  /// name of the finger_21 joint that mimics the knuckle, with the prefix of the configured names
+  const std::string &mimicJointName() const
+  {
+    return mimic_joint_name_;
+  }
+
+  /*!
+   * \brief Maps values in ROS joint order [rad] to SDH axis order [deg].
+   *
+   * \param joints size() values in joint order
+   * \param axes receives size() values in axis order, must not alias \a joints
+   */
+  void jointsToAxesDeg(const double *joints, double *axes) const
+  {
+    gather(joints, joint_of_axis_, axes);
+    scale(axes, size(), kDegPerRad);
+  }
+
+  /*!
+   * \brief Maps values in SDH axis order [deg] to ROS joint order [rad].
+   *
+   * \param axes size() values in axis order
+   * \param joints receives size() values in joint order, must not alias \a axes
+   */
+  void axesToJointsRad(const double *axes, double *joints) const
+  {
+    gather(axes, axis_of_joint_, joints);
+    scale(joints, size(), kRadPerDeg);
+  }
+
+  /*!
+   * \brief Computes for each SDH axis the index of its joint in a list of names, e.g. of a trajectory goal.
+   *
+   * Goals in the configured joint order, the usual case, just copy the table.
+   * \param names joint names of the message
+   * \param index_of_axis receives size() indices into \a names
+   * \return false if a configured joint is missing in \a names
+   */
+  bool indexOfAxes(const std::vector<std::string> &names, std::vector<int> &index_of_axis) const
+  {
+    index_of_axis.resize(size());
+    if (names == joint_names_)
+    {
+      index_of_axis = joint_of_axis_;
+      return true;
+    }
+    for (size_t a = 0; a < size(); a++)
+    {
+      const std::string &name = joint_names_[joint_of_axis_[a]];
+      index_of_axis[a] = -1;
+      for (size_t i = 0; i < names.size(); i++)
+      {
+        if (names[i] == name)
+        {
+          index_of_axis[a] = i;
+          break;
+        }
+      }
+      if (index_of_axis[a] < 0)
+        return false;
+    }
+    return true;
+  }
+
+  /// out[i] = in[index[i]]
+  static void gather(const double *in, const std::vector<int> &index, double *out)
+  {
+    const size_t n = index.size();
+    const int *idx = index.data();
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[idx[i]];
+  }
+
+  /// values[i] *= factor, contiguous so it vectorizes
+  static void scale(double *values, size_t n, double factor)
+  {
+    for (size_t i = 0; i < n; i++)
+      values[i] *= factor;
+  }
+
+private:
+  /// name suffix of the joint driven by each SDH axis, in axis order
+  static const std::vector<std::string> &axisSuffixes()
+  {
+    static const std::vector<std::string> suffixes = {
+      "knuckle_joint", "finger_22_joint", "finger_23_joint", "thumb_2_joint", "thumb_3_joint", "finger_12_joint",
+      "finger_13_joint"
+    };
+    return suffixes;
+  }
+
+  static bool endsWith(const std::string &s, const std::string &suffix)
+  {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  std::vector<std::string> joint_names_;
+  std::vector<int> axis_of_joint_;
+  std::vector<int> joint_of_axis_;
+  std::string mimic_joint_name_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_JOINT_MAPPING_H
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_PRESSURE_CALIBRATION_H
+#define SCHUNK_SDH_ROS_PRESSURE_CALIBRATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Converts raw texel values to pressure [Pa] with per-texel tables.
+ *
+ * The model is pressure = curve(raw) * gain + offset. The curve is the identity, or a piecewise linear curve through
+ * the configured knots that is tabulated for every possible raw value. Gain and offset can be given for the whole
+ * hand, per matrix or per texel; prepare() expands them into one entry per texel of the frame layout. Conversion is
+ * then a single multiply-add per texel over contiguous arrays, which the compiler vectorizes, and no division.
+ *
+ * Parameters, all optional, below the given namespace:
+ *   gain: [Pa per raw unit] or, with a curve, the factor applied to the curve; 1, nb_matrices or nb_texels values
+ *   offset: [Pa], same forms as gain
+ * Per-matrix and per-texel values are given in the matrix order of tactile_data, see setOrder(), each matrix row by
+ * row like its tactile_array.
+ *   curve_raw, curve_pressure: knots of the nonlinear curve, raw values strictly increasing, pressures in [Pa]
+ */
+class PressureCalibration
+{
+public:
+  /*!
+   * \brief Sets the model.
+   *
+   * \param gain 1, nb_matrices or nb_texels factors
+   * \param offset empty, 1, nb_matrices or nb_texels offsets [Pa]
+   * \param curve_raw raw values of the curve knots, empty for the linear model
+   * \param curve_pressure pressures at the knots [Pa]
+   * \param error receives a description if the model is malformed
+   * \return true on success
+   */
+  bool configure(const std::vector<double> &gain, const std::vector<double> &offset,
+                 const std::vector<double> &curve_raw, const std::vector<double> &curve_pressure, std::string &error)
+  {
+    layout_.clear();
+    curve_.clear();
+    if (gain.empty())
+    {
+      error = "no gain";
+      return false;
+    }
+    gain_param_ = gain;
+    offset_param_ = offset.empty() ? std::vector<double>(1, 0.0) : offset;
+
+    if (curve_raw.size() != curve_pressure.size())
+    {
+      error = "curve_raw and curve_pressure differ in size";
+      return false;
+    }
+    if (curve_raw.empty())
+      return true;
+    if (curve_raw.size() < 2)
+    {
+      error = "a curve needs at least two knots";
+      return false;
+    }
+    for (size_t k = 1; k < curve_raw.size(); k++)
+    {
+      if (curve_raw[k] <= curve_raw[k - 1])
+      {
+        error = "curve_raw is not strictly increasing";
+        return false;
+      }
+    }
+    // tabulate for every raw value, constant beyond the outer knots
+    curve_.resize(kCurveSize);
+    size_t k = 0;
+    for (size_t raw = 0; raw < kCurveSize; raw++)
+    {
+      while (k + 2 < curve_raw.size() && raw >= curve_raw[k + 1])
+        ++k;
+      const double s = std::max(0.0, std::min(1.0, (raw - curve_raw[k]) / (curve_raw[k + 1] - curve_raw[k])));
+      curve_[raw] = curve_pressure[k] + s * (curve_pressure[k + 1] - curve_pressure[k]);
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Sets the matrix order of per-matrix and per-texel values, call before prepare().
+   *
+   * \param order SDHLibrary matrix of each matrix of the values, i.e. dsa_reorder; empty for SDHLibrary order
+   */
+  void setOrder(const std::vector<int> &order)
+  {
+    order_ = order;
+    layout_.clear();
+  }
+
+  /*!
+   * \brief Loads the model from the parameter server.
+   *
+   * \param nh node handle
+   * \param ns namespace of the parameters, relative to \a nh
+   * \param default_gain gain used if the parameter is not set [Pa per raw unit]
+   * \param error receives a description if the model is malformed
+   * \return true on success
+   */
+  bool load(const ros::NodeHandle &nh, const std::string &ns, double default_gain, std::string &error)
+  {
+    std::vector<double> gain, offset, curve_raw, curve_pressure;
+    nh.param(ns + "/gain", gain, std::vector<double>(1, default_gain));
+    nh.param(ns + "/offset", offset, std::vector<double>());
+    nh.param(ns + "/curve_raw", curve_raw, std::vector<double>());
+    nh.param(ns + "/curve_pressure", curve_pressure, std::vector<double>());
+    return configure(gain, offset, curve_raw, curve_pressure, error);
+  }
+
+  /// true if the tables were built for this layout
+  bool matches(const std::vector<size_t> &layout) const
+  {
+    return !layout_.empty() && layout == layout_;
+  }
+
+  /*!
+   * \brief Expands gain and offset into per-texel tables.
+   *
+   * \param layout first texel of each matrix plus the total texel count, see DsaFrame::offset
+   * \param error receives a description if gain or offset do not fit the layout
+   * \return true on success
+   */
+  bool prepare(const std::vector<size_t> &layout, std::string &error)
+  {
+    layout_.clear();
+    if (layout.size() < 2)
+    {
+      error = "no tactile matrices";
+      return false;
+    }
+    if (!expand(gain_param_, layout, order_, gain_, "gain", error)
+        || !expand(offset_param_, layout, order_, offset_, "offset", error))
+      return false;
+    layout_ = layout;
+    return true;
+  }
+
+  /*!
+   * \brief Converts a run of texels, e.g. one matrix.
+   *
+   * \param texels raw values
+   * \param first index of the first texel in the frame layout
+   * \param n number of texels
+   * \param pressure receives \a n pressures [Pa]
+   */
+  void convert(const SDH::cDSA::tTexel *texels, size_t first, size_t n, double *pressure) const
+  {
+    const double *gain = gain_.data() + first;
+    const double *offset = offset_.data() + first;
+    if (curve_.empty())
+    {
+      for (size_t i = 0; i < n; i++)
+        pressure[i] = texels[i] * gain[i] + offset[i];
+    }
+    else
+    {
+      const double *curve = curve_.data();
+      for (size_t i = 0; i < n; i++)
+        pressure[i] = curve[std::min<size_t>(texels[i], kCurveSize - 1)] * gain[i] + offset[i];
+    }
+  }
+
+private:
+  static const size_t kCurveSize = 4096;  // texels are 12 bit
+
+  static bool expand(const std::vector<double> &values, const std::vector<size_t> &layout,
+                     const std::vector<int> &order, std::vector<double> &table, const char *name, std::string &error)
+  {
+    const size_t matrices = layout.size() - 1;
+    const size_t texels = layout.back();
+    table.resize(texels);
+    if (values.size() == 1)
+    {
+      std::fill(table.begin(), table.end(), values[0]);
+      return true;
+    }
+    if (values.size() != matrices && values.size() != texels)
+    {
+      error = std::string(name) + " has " + std::to_string(values.size()) + " values, expected 1, "
+          + std::to_string(matrices) + " or " + std::to_string(texels);
+      return false;
+    }
+
+    // SDHLibrary matrix of each matrix of the values
+    std::vector<int> matrix_of(matrices);
+    if (order.empty())
+    {
+      for (size_t i = 0; i < matrices; i++)
+        matrix_of[i] = i;
+    }
+    else
+    {
+      std::vector<bool> covered(matrices, false);
+      for (size_t i = 0; i < order.size(); i++)
+      {
+        if (order.size() != matrices || order[i] < 0 || order[i] >= static_cast<int>(matrices) || covered[order[i]])
+        {
+          error = std::string(name) + " is given per matrix or texel, but dsa_reorder is not a permutation of the "
+              + std::to_string(matrices) + " matrices";
+          return false;
+        }
+        covered[order[i]] = true;
+        matrix_of[i] = order[i];
+      }
+    }
+
+    if (values.size() == matrices)
+    {
+      for (size_t i = 0; i < matrices; i++)
+      {
+        const int m = matrix_of[i];
+        std::fill(table.begin() + layout[m], table.begin() + layout[m + 1], values[i]);
+      }
+    }
+    else
+    {
+      std::vector<double>::const_iterator value = values.begin();
+      for (size_t i = 0; i < matrices; i++)
+      {
+        const int m = matrix_of[i];
+        const size_t n = layout[m + 1] - layout[m];
+        std::copy(value, value + n, table.begin() + layout[m]);
+        value += n;
+      }
+    }
+    return true;
+  }
+
+  std::vector<double> gain_param_;
+  std::vector<double> offset_param_;
+  std::vector<int> order_;      // SDHLibrary matrix of each matrix of the parameters, empty for SDHLibrary order
+  std::vector<double> curve_;   // pressure for each raw value, empty for the linear model
+  std::vector<size_t> layout_;  // layout the tables were built for
+  std::vector<double> gain_;    // per texel
+  std::vector<double> offset_;  // per texel
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_PRESSURE_CALIBRATION_H
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_RECONNECT_BACKOFF_H
+#define SCHUNK_SDH_ROS_RECONNECT_BACKOFF_H
+
+#include <algorithm>
+#include <random>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Delays between reconnection attempts.
+ *
+ * The first attempt after reset() is immediate, so a short outage costs a single connect. Every failed attempt doubles
+ * the delay up to the maximum. The jitter spreads the delays randomly, so several nodes behind the same gateway do not
+ * retry in lockstep.
+ */
+class ReconnectBackoff
+{
+public:
+  /*!
+   * \param min_delay delay after the first failed attempt [s]
+   * \param max_delay upper bound of the delay [s]
+   * \param jitter relative random deviation of each delay, e.g. 0.2 for +-20%
+   */
+  ReconnectBackoff(double min_delay = 0.1, double max_delay = 5.0, double jitter = 0.2) :
+      random_(std::random_device()())
+  {
+    configure(min_delay, max_delay, jitter);
+  }
+
+  void configure(double min_delay, double max_delay, double jitter)
+  {
+    min_delay_ = std::max(min_delay, 0.0);
+    max_delay_ = std::max(max_delay, min_delay_);
+    jitter_ = std::min(std::max(jitter, 0.0), 1.0);
+    reset();
+  }
+
+  /// the next attempt is immediate again, call after a successful connect
+  void reset()
+  {
+    attempts_ = 0;
+    delay_ = 0.0;
+  }
+
+  /// delay before the next attempt [s], counts the attempt
+  double next()
+  {
+    const double delay = delay_;
+    delay_ = (attempts_++ == 0) ? min_delay_ : std::min(delay_ * 2.0, max_delay_);
+    if (delay <= 0.0)
+      return 0.0;
+    std::uniform_real_distribution<double> spread(1.0 - jitter_, 1.0 + jitter_);
+    return delay * spread(random_);
+  }
+
+  /// attempts since the last reset()
+  unsigned int attempts() const
+  {
+    return attempts_;
+  }
+
+private:
+  double min_delay_, max_delay_, jitter_;
+  unsigned int attempts_;
+  double delay_;  // [s] before the jitter
+  std::mt19937 random_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_RECONNECT_BACKOFF_H
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_REUSABLE_MESSAGE_H
+#define SCHUNK_SDH_ROS_REUSABLE_MESSAGE_H
+
+#include <cstdint>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Message instance that is published as shared pointer and reused in the next cycle.
+ *
+ * roscpp serializes a message for remote subscribers within publish() and only keeps a reference for intra-process
+ * subscribers. As long as nobody holds on to the last published instance it is handed out again, so vectors keep
+ * their capacity and constant fields (names, sizes) are filled only once by the prototype. Otherwise a fresh copy of
+ * the prototype is allocated and counted.
+ */
+template<typename M>
+class ReusableMessage
+{
+public:
+  ReusableMessage() :
+      allocations_(0)
+  {
+  }
+
+  /*!
+   * \brief Sets the prototype new instances are copied from.
+   *
+   * \param prototype message with all constant fields filled and all vectors sized
+   */
+  void reset(const M &prototype)
+  {
+    prototype_ = prototype;
+    msg_.reset();
+  }
+
+  /*!
+   * \brief Returns an instance that may be modified and published.
+   *
+   * Fields that are not constant still hold the values of the previous cycle.
+   */
+  boost::shared_ptr<M> &acquire()
+  {
+    if (!msg_ || !msg_.unique())
+    {
+      msg_ = boost::make_shared<M>(prototype_);
+      ++allocations_;
+    }
+    return msg_;
+  }
+
+  /// the instance of the last acquire(), e.g. to publish it once more, empty before the first acquire()
+  boost::shared_ptr<const M> current() const
+  {
+    return msg_;
+  }
+
+  /// number of instances allocated so far, stays constant in steady state
+  uint64_t allocations() const
+  {
+    return allocations_;
+  }
+
+private:
+  M prototype_;
+  boost::shared_ptr<M> msg_;
+  uint64_t allocations_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_REUSABLE_MESSAGE_H
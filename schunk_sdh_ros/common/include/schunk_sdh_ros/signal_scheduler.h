@@ -0,0 +1,156 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_SIGNAL_SCHEDULER_H
+#define SCHUNK_SDH_ROS_SIGNAL_SCHEDULER_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Decides which signals are due in which cycle of a fixed-rate loop.
+ *
+ * Every signal gets a period in loop cycles derived from its requested rate. Signals slower than the loop get a
+ * phase offset chosen such that as few of them as possible fall into the same cycle, e.g. temperatures and
+ * diagnostics at 1 Hz are never read in the same cycle as long as there is room for them.
+ */
+class SignalScheduler
+{
+public:
+  SignalScheduler() :
+      base_rate_(1.0), cycle_(0)
+  {
+  }
+
+  /*!
+   * \brief Clears all signals and sets the loop rate.
+   *
+   * \param base_rate rate of the loop calling tick() [Hz]
+   */
+  void reset(double base_rate)
+  {
+    base_rate_ = base_rate;
+    cycle_ = 0;
+    signals_.clear();
+  }
+
+  /*!
+   * \brief Registers a signal.
+   *
+   * \param name name for logging
+   * \param rate requested rate [Hz], capped at the loop rate, a rate <= 0 disables the signal
+   * \return id used with due()
+   */
+  int add(const std::string &name, double rate)
+  {
+    Signal s;
+    s.name = name;
+    s.period = 0;
+    if (rate > 0.0)
+      s.period = std::max(1, static_cast<int>(std::floor(base_rate_ / rate + 0.5)));
+    s.phase = 0;
+    signals_.push_back(s);
+    place(signals_.size() - 1);
+    return signals_.size() - 1;
+  }
+
+  /// advances to the next loop cycle
+  void tick()
+  {
+    ++cycle_;
+  }
+
+  /// true if the signal has to be served in the current cycle
+  bool due(int id) const
+  {
+    const Signal &s = signals_[id];
+    return s.period > 0 && (cycle_ % s.period) == static_cast<unsigned long>(s.phase);
+  }
+
+  /// effective rate of a signal after rounding to whole cycles [Hz]
+  double rate(int id) const
+  {
+    return signals_[id].period > 0 ? base_rate_ / signals_[id].period : 0.0;
+  }
+
+  const std::string &name(int id) const
+  {
+    return signals_[id].name;
+  }
+
+private:
+  struct Signal
+  {
+    std::string name;
+    int period;  // in cycles, 0 if disabled
+    int phase;   // cycle offset within the period
+  };
+
+  static int gcd(int a, int b)
+  {
+    while (b != 0)
+    {
+      const int t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  /// chooses the phase of a new signal that collides least with the signals already placed
+  void place(size_t id)
+  {
+    Signal &s = signals_[id];
+    if (s.period <= 1)
+      return;
+
+    int best_phase = 0;
+    int best_load = -1;
+    for (int phase = 0; phase < s.period; phase++)
+    {
+      // count the slow signals due in the cycle of this phase, fast ones hit every phase anyway
+      int load = 0;
+      for (size_t j = 0; j < id; j++)
+      {
+        const Signal &o = signals_[j];
+        if (o.period > 1 && ((phase - o.phase) % gcd(o.period, s.period)) == 0)
+          ++load;
+      }
+      if (best_load < 0 || load < best_load)
+      {
+        best_load = load;
+        best_phase = phase;
+      }
+      if (best_load == 0)
+        break;
+    }
+    s.phase = best_phase;
+  }
+
+  double base_rate_;
+  unsigned long cycle_;
+  std::vector<Signal> signals_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_SIGNAL_SCHEDULER_H
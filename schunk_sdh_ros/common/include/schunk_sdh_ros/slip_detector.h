@@ -0,0 +1,163 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_SLIP_DETECTOR_H
+#define SCHUNK_SDH_ROS_SLIP_DETECTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+
+#include <schunk_sdh_ros/dsa_frame.h>
+
+namespace schunk_sdh_ros
+{
+
+/// slip of one matrix in one frame
+struct Slip
+{
+  int matrix;           // SDHLibrary matrix
+  bool onset;           // first frame of the slip, the matrix was not reported as slipping in the previous frame
+  double x_velocity;    // velocity of the centre of pressure [mm/s]
+  double y_velocity;    // [mm/s]
+  double change_rate;   // summed texel change relative to the summed texel values [1/s]
+};
+
+/*!
+ * \brief Detects slip from consecutive frames while a matrix stays in contact.
+ *
+ * Each frame is compared with the previous one only, so a slip is reported in the frame it shows up in. A matrix slips
+ * if its centre of pressure moves faster than the velocity threshold, or if its texels change faster than the change
+ * rate threshold, which catches rolling and partial slip that leave the centre of pressure in place. A slip is only
+ * reported once a matrix exceeded a threshold in min_frames consecutive frame pairs, each frame beyond the first adds
+ * one frame of latency. The default of 2 filters a single jump of the contact, e.g. when the grasp settles, at one
+ * frame of latency. A single disturbed frame affects the pairs before and after it and is only filtered with 3. The
+ * previous frame is kept per matrix in buffers that are reused, so detecting does not allocate.
+ */
+class SlipDetector
+{
+public:
+  SlipDetector() :
+      velocity_threshold_(20.0), change_rate_threshold_(3.0), min_frames_(2)
+  {
+  }
+
+  /*!
+   * \param velocity centre of pressure velocity above which a matrix slips [mm/s]
+   * \param change_rate relative texel change rate above which a matrix slips [1/s]
+   * \param min_frames consecutive frame pairs above a threshold before a slip is reported, at least 1
+   */
+  void setThresholds(double velocity, double change_rate, int min_frames = 2)
+  {
+    velocity_threshold_ = velocity;
+    change_rate_threshold_ = change_rate;
+    min_frames_ = std::max(min_frames, 1);
+  }
+
+  /// forgets the previous frame, e.g. while nobody listens
+  void reset()
+  {
+    for (size_t m = 0; m < matrices_.size(); m++)
+      matrices_[m].valid = false;
+  }
+
+  /*!
+   * \brief Compares a frame with the previous one.
+   *
+   * \param frame new frame
+   * \param contacts contact of each matrix of \a frame, SDHLibrary matrix order
+   * \param slips receives the slipping matrices
+   */
+  void update(const DsaFrame &frame, const std::vector<SDH::cDSA::sContactInfo> &contacts, std::vector<Slip> &slips)
+  {
+    slips.clear();
+    if (matrices_.size() != frame.matrices())
+      matrices_.assign(frame.matrices(), State());
+
+    for (size_t m = 0; m < frame.matrices() && m < contacts.size(); m++)
+    {
+      State &s = matrices_[m];
+      const SDH::cDSA::tTexel *raw = frame.matrix(m);
+      const size_t n = frame.offset[m + 1] - frame.offset[m];
+      const SDH::cDSA::sContactInfo &contact = contacts[m];
+      const bool in_contact = contact.force > 0;
+
+      bool above = false, slipping = false;
+      const double dt = s.valid ? (frame.stamp - s.stamp).toSec() : 0.0;
+      if (s.valid && s.in_contact && in_contact && dt > 0.0 && s.raw.size() == n)
+      {
+        double change = 0.0, total = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+          change += std::abs(static_cast<int>(raw[i]) - static_cast<int>(s.raw[i]));
+          total += raw[i];
+        }
+        Slip slip;
+        slip.matrix = m;
+        slip.onset = !s.slipping;
+        slip.x_velocity = (contact.cog_x - s.cog_x) / dt;
+        slip.y_velocity = (contact.cog_y - s.cog_y) / dt;
+        slip.change_rate = change / std::max(total, 1.0) / dt;
+        above = std::sqrt(slip.x_velocity * slip.x_velocity + slip.y_velocity * slip.y_velocity)
+            > velocity_threshold_ || slip.change_rate > change_rate_threshold_;
+        slipping = above && s.frames_above + 1 >= min_frames_;
+        if (slipping)
+          slips.push_back(slip);
+      }
+
+      s.frames_above = above ? s.frames_above + 1 : 0;
+      s.valid = true;
+      s.in_contact = in_contact;
+      s.slipping = slipping;
+      s.cog_x = contact.cog_x;
+      s.cog_y = contact.cog_y;
+      s.stamp = frame.stamp;
+      s.raw.assign(raw, raw + n);
+    }
+  }
+
+private:
+  /// previous frame of one matrix
+  struct State
+  {
+    bool valid;
+    bool in_contact;
+    bool slipping;
+    int frames_above;  // consecutive frame pairs above a threshold
+    double cog_x, cog_y;  // [mm]
+    ros::Time stamp;
+    std::vector<SDH::cDSA::tTexel> raw;
+
+    State() :
+        valid(false), in_contact(false), slipping(false), frames_above(0), cog_x(0.0), cog_y(0.0)
+    {
+    }
+  };
+
+  double velocity_threshold_;     // [mm/s]
+  double change_rate_threshold_;  // [1/s]
+  int min_frames_;
+  std::vector<State> matrices_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_SLIP_DETECTOR_H
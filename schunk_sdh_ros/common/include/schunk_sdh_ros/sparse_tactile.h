@@ -0,0 +1,207 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_SPARSE_TACTILE_H
+#define SCHUNK_SDH_ROS_SPARSE_TACTILE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <schunk_sdh/TactileSensor.h>
+#include <schunk_sdh/TactileMatrix.h>
+#include <schunk_sdh_ros/SparseTactileSensor.h>
+#include <schunk_sdh_ros/SparseTactileMatrix.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Encodes dense TactileSensor frames as SparseTactileSensor keyframes and deltas.
+ *
+ * A keyframe lists all non-zero texels. A delta lists the texels that differ by more than the threshold from the value
+ * last transmitted for them, so the reconstruction error of a texel never exceeds the threshold and does not drift.
+ * Every keyframe_interval frames, and whenever the matrix layout changes, a keyframe is sent.
+ */
+class SparseTactileEncoder
+{
+public:
+  SparseTactileEncoder() :
+      keyframe_interval_(30), threshold_(0), frame_(0), since_keyframe_(0), valid_(false)
+  {
+  }
+
+  /*!
+   * \param keyframe_interval frames between two keyframes, 1 sends only keyframes
+   * \param threshold raw change a texel needs to be part of a delta, 0 sends every change
+   */
+  void configure(int keyframe_interval, int threshold)
+  {
+    keyframe_interval_ = keyframe_interval < 1 ? 1 : keyframe_interval;
+    threshold_ = threshold < 0 ? 0 : threshold;
+  }
+
+  /// makes the next frame a keyframe, e.g. when subscribers may have missed frames
+  void reset()
+  {
+    valid_ = false;
+  }
+
+  /*!
+   * \brief Encodes one frame.
+   *
+   * \param dense frame to encode
+   * \param sparse receives the encoding, vectors keep their capacity
+   */
+  void encode(const schunk_sdh::TactileSensor &dense, SparseTactileSensor &sparse)
+  {
+    bool keyframe = !valid_ || since_keyframe_ >= keyframe_interval_ || sent_.size() != dense.tactile_matrix.size();
+    for (size_t m = 0; m < dense.tactile_matrix.size() && !keyframe; m++)
+      keyframe = sent_[m].size() != dense.tactile_matrix[m].tactile_array.size();
+
+    sparse.header = dense.header;
+    sparse.keyframe = keyframe;
+    sparse.frame = frame_++;
+    sparse.tactile_matrix.resize(dense.tactile_matrix.size());
+    sent_.resize(dense.tactile_matrix.size());
+    for (size_t m = 0; m < dense.tactile_matrix.size(); m++)
+    {
+      const schunk_sdh::TactileMatrix &tm = dense.tactile_matrix[m];
+      SparseTactileMatrix &sm = sparse.tactile_matrix[m];
+      std::vector<int16_t> &sent = sent_[m];
+      sm.matrix_id = tm.matrix_id;
+      sm.cells_x = tm.cells_x;
+      sm.cells_y = tm.cells_y;
+      sm.index.clear();
+      sm.value.clear();
+      if (keyframe)
+      {
+        sent.assign(tm.tactile_array.begin(), tm.tactile_array.end());
+        for (size_t i = 0; i < sent.size(); i++)
+        {
+          if (sent[i] == 0)
+            continue;
+          sm.index.push_back(i);
+          sm.value.push_back(sent[i]);
+        }
+      }
+      else
+      {
+        for (size_t i = 0; i < sent.size(); i++)
+        {
+          const int16_t value = tm.tactile_array[i];
+          if (std::abs(value - sent[i]) <= threshold_)
+            continue;
+          sm.index.push_back(i);
+          sm.value.push_back(value);
+          sent[i] = value;
+        }
+      }
+    }
+    since_keyframe_ = keyframe ? 1 : since_keyframe_ + 1;
+    valid_ = true;
+  }
+
+private:
+  int keyframe_interval_;
+  int threshold_;
+  uint32_t frame_;
+  int since_keyframe_;
+  bool valid_;
+  std::vector<std::vector<int16_t> > sent_;  // texel values as reconstructed by the subscribers
+};
+
+/*!
+ * \brief Reconstructs dense TactileSensor frames on the subscriber side.
+ *
+ * Feed every received SparseTactileSensor message to apply(). After a lost message the state is invalid until the next
+ * keyframe arrives.
+ */
+class SparseTactileDecoder
+{
+public:
+  SparseTactileDecoder() :
+      next_frame_(0), valid_(false)
+  {
+  }
+
+  /*!
+   * \brief Applies a keyframe or delta.
+   *
+   * \param sparse received message
+   * \return true if frame() now holds a valid reconstruction
+   */
+  bool apply(const SparseTactileSensor &sparse)
+  {
+    if (!sparse.keyframe && (!valid_ || sparse.frame != next_frame_
+        || sparse.tactile_matrix.size() != frame_.tactile_matrix.size()))
+    {
+      valid_ = false;
+      return false;
+    }
+
+    frame_.header = sparse.header;
+    frame_.tactile_matrix.resize(sparse.tactile_matrix.size());
+    for (size_t m = 0; m < sparse.tactile_matrix.size(); m++)
+    {
+      const SparseTactileMatrix &sm = sparse.tactile_matrix[m];
+      schunk_sdh::TactileMatrix &tm = frame_.tactile_matrix[m];
+      const size_t size = sm.cells_x * sm.cells_y;
+      if (sparse.keyframe)
+      {
+        tm.matrix_id = sm.matrix_id;
+        tm.cells_x = sm.cells_x;
+        tm.cells_y = sm.cells_y;
+        tm.tactile_array.assign(size, 0);
+      }
+      else if (tm.tactile_array.size() != size)
+      {
+        valid_ = false;
+        return false;
+      }
+      for (size_t k = 0; k < sm.index.size() && k < sm.value.size(); k++)
+      {
+        if (sm.index[k] < size)
+          tm.tactile_array[sm.index[k]] = sm.value[k];
+      }
+    }
+    next_frame_ = sparse.frame + 1;
+    valid_ = true;
+    return true;
+  }
+
+  /// true if frame() is a valid reconstruction
+  bool valid() const
+  {
+    return valid_;
+  }
+
+  /// the reconstructed frame, valid until the next apply()
+  const schunk_sdh::TactileSensor &frame() const
+  {
+    return frame_;
+  }
+
+private:
+  schunk_sdh::TactileSensor frame_;
+  uint32_t next_frame_;
+  bool valid_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_SPARSE_TACTILE_H
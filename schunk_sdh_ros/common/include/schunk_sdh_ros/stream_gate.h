@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_STREAM_GATE_H
+#define SCHUNK_SDH_ROS_STREAM_GATE_H
+
+#include <cstdint>
+#include <string>
+
+#include <ros/ros.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Decides per frame whether an output stream is published.
+ *
+ * A stream publishes every n-th frame and at most at its rate cap, measured on the frame stamps. Both limits are
+ * checked independently and only restart when a frame is published: a frame is due once at least n frames passed
+ * since the last published one and its stamp reached the schedule of the cap. A frame held back by the cap is thus
+ * replaced by the next frame the cap allows, not by the next n-th frame, and the stream runs at the lower of frame
+ * rate / n and the cap. The cap keeps a schedule instead of a minimum gap, so the average rate matches the cap even
+ * if it is not a divisor of the frame rate. Without subscribers a stream is never due, so it costs nothing.
+ */
+class StreamGate
+{
+public:
+  StreamGate() :
+      decimation_(1), period_(0.0), since_(0), next_(0.0)
+  {
+  }
+
+  /*!
+   * \param decimation publish every n-th frame
+   * \param max_rate rate cap [Hz], 0 for none
+   */
+  void configure(int decimation, double max_rate)
+  {
+    decimation_ = decimation < 1 ? 1 : decimation;
+    period_ = max_rate > 0.0 ? 1.0 / max_rate : 0.0;
+    since_ = decimation_ - 1;
+    next_ = 0.0;
+  }
+
+  /*!
+   * \brief Reads decimation and rate cap of stream \a name.
+   *
+   * \param nh node handle with the parameters stream_decimation/<name> and stream_rates/<name>
+   * \param default_rate rate cap if stream_rates/<name> is not set [Hz]
+   */
+  void load(const ros::NodeHandle &nh, const std::string &name, double default_rate)
+  {
+    int decimation;
+    double max_rate;
+    nh.param("stream_decimation/" + name, decimation, 1);
+    nh.param("stream_rates/" + name, max_rate, default_rate);
+    configure(decimation, max_rate);
+  }
+
+  /*!
+   * \brief Decides about one frame, call once per frame.
+   *
+   * \param stamp acquisition time of the frame
+   * \param subscribers number of subscribers of the stream
+   * \return true if the frame is to be published
+   */
+  bool due(const ros::Time &stamp, uint32_t subscribers)
+  {
+    if (subscribers == 0)
+    {
+      since_ = decimation_ - 1;  // a new subscriber gets the next frame
+      return false;
+    }
+    if (++since_ < static_cast<uint64_t>(decimation_))
+      return false;
+    if (period_ > 0.0)
+    {
+      const double t = stamp.toSec();
+      if (t < next_)
+        return false;  // since_ keeps counting, so the next frame is a candidate again
+      next_ = (t - next_ > period_) ? t + period_ : next_ + period_;
+    }
+    since_ = 0;
+    return true;
+  }
+
+private:
+  int decimation_;
+  double period_;  // [s], 0 for no cap
+  uint64_t since_;  // frames since the last published one
+  double next_;    // earliest stamp of the next published frame [s]
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_STREAM_GATE_H
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TACTILE_DECODER_H
+#define SCHUNK_SDH_ROS_TACTILE_DECODER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+#include <schunk_sdh/TactileSensor.h>
+#include <schunk_sdh/TactileMatrix.h>
+#include <schunk_sdh/PressureArrayList.h>
+
+#include <schunk_sdh_ros/contact_segmenter.h>
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/pressure_calibration.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Derives all tactile outputs from a DsaFrame in one pass.
+ *
+ * Each matrix is visited once: its raw texels are copied into the TactileSensor message, converted to pressure,
+ * reduced to a contact and split into contact regions while they are still in cache. A frame is decoded only once per
+ * sensor timestamp, so callers can hand in the newest frame every cycle. Outputs keep their capacity between frames.
+ */
+class TactileDecoder
+{
+public:
+  TactileDecoder() :
+      default_gain_(0.0), contact_area_threshold_(10.0), contact_force_threshold_(10.0), decoded_(false), timestamp_(0)
+  {
+  }
+
+  /*!
+   * \brief Loads the pressure calibration, see PressureCalibration.
+   *
+   * \param default_gain linear calibration used without parameters or if they do not fit the sensor [Pa per raw unit]
+   */
+  bool loadCalibration(const ros::NodeHandle &nh, const std::string &ns, double default_gain, std::string &error)
+  {
+    default_gain_ = default_gain;
+    return calibration_.load(nh, ns, default_gain, error);
+  }
+
+  /// linear calibration with one gain for all texels, without parameters [Pa per raw unit]
+  void setLinearCalibration(double gain)
+  {
+    std::string error;
+    default_gain_ = gain;
+    calibration_.configure(std::vector<double>(1, gain), std::vector<double>(), std::vector<double>(),
+                           std::vector<double>(), error);
+  }
+
+  /// SDHLibrary matrix of each TactileSensor matrix, also the order of the calibration tables, call before decode()
+  void setReorder(const std::vector<int> &reorder)
+  {
+    reorder_ = reorder;
+    calibration_.setOrder(reorder);
+  }
+
+  /*!
+   * \brief Sets the contact thresholds, same meaning as in cDSA::GetContactInfo().
+   *
+   * \param area texels above this raw value belong to the contact area
+   * \param force a matrix is in contact if the raw values of its contact area sum up to at least this
+   */
+  void setContactThresholds(double area, double force)
+  {
+    contact_area_threshold_ = area;
+    contact_force_threshold_ = force;
+  }
+
+  /// index in the TactileSensor message of SDHLibrary matrix \a m, -1 if it is not published
+  int messageIndex(int m) const
+  {
+    return (m >= 0 && m < static_cast<int>(message_of_matrix_.size())) ? message_of_matrix_[m] : -1;
+  }
+
+  /// true if \a frame has not been decoded yet
+  bool isNew(const DsaFrame &frame) const
+  {
+    return frame.seq != 0 && (!decoded_ || frame.timestamp != timestamp_);
+  }
+
+  /*!
+   * \brief Decodes a frame into all outputs that are given.
+   *
+   * \param frame source frame
+   * \param tactile receives the raw matrices in reorder order, may be 0
+   * \param pressure receives the pressures [Pa] in SDHLibrary order, may be 0
+   * \param contacts receives the contact of each matrix in SDHLibrary order, force [N], area [mm^2], cog [mm], may be 0
+   * \param regions receives the connected contact regions of all matrices, may be 0
+   * \return false if the frame was decoded before, the outputs are untouched then
+   */
+  bool decode(const DsaFrame &frame, schunk_sdh::TactileSensor *tactile, schunk_sdh::PressureArrayList *pressure,
+              std::vector<SDH::cDSA::sContactInfo> *contacts, std::vector<ContactRegion> *regions = 0)
+  {
+    if (!isNew(frame))
+      return false;
+    decoded_ = true;
+    timestamp_ = frame.timestamp;
+    if (!calibration_.matches(frame.offset))
+      prepare(frame);
+
+    const size_t matrices = frame.matrices();
+    if (tactile)
+    {
+      tactile->header.stamp = frame.stamp;
+      tactile->tactile_matrix.resize(reorder_.size());
+    }
+    if (pressure)
+    {
+      pressure->header.stamp = frame.stamp;
+      pressure->pressure_list.resize(matrices);
+    }
+    if (contacts)
+      contacts->resize(matrices);
+    if (regions)
+      regions->clear();
+
+    for (size_t m = 0; m < matrices; m++)
+    {
+      const SDH::cDSA::tTexel *raw = frame.matrix(m);
+      const size_t n = frame.offset[m + 1] - frame.offset[m];
+
+      if (tactile && message_of_matrix_[m] >= 0)
+      {
+        schunk_sdh::TactileMatrix &tm = tactile->tactile_matrix[message_of_matrix_[m]];
+        tm.matrix_id = message_of_matrix_[m];
+        tm.cells_x = frame.cells_x[m];
+        tm.cells_y = frame.cells_y[m];
+        tm.tactile_array.assign(raw, raw + n);
+      }
+
+      double *p = scratch_.data();
+      if (pressure)
+      {
+        schunk_sdh::PressureArray &pa = pressure->pressure_list[m];
+        if (pa.sensor_name != sensor_names_[m])
+          pa.sensor_name = sensor_names_[m];
+        pa.cells_x = frame.cells_x[m];
+        pa.cells_y = frame.cells_y[m];
+        pa.pressure.resize(n);
+        p = pa.pressure.data();
+      }
+      if (pressure || contacts || regions)
+        calibration_.convert(raw, frame.offset[m], n, p);
+
+      if (contacts)
+        (*contacts)[m] = contact(frame, m, raw, p);
+      if (regions)
+        segmenter_.segment(m, frame.cells_x[m], frame.cells_y[m], raw, p, frame.texel_width[m],
+                           frame.texel_height[m], contact_area_threshold_, contact_force_threshold_, *regions);
+    }
+    return true;
+  }
+
+private:
+  /// contact of one matrix, like cDSA::GetContactInfo() but with the force from the calibrated pressures
+  SDH::cDSA::sContactInfo contact(const DsaFrame &frame, size_t m, const SDH::cDSA::tTexel *raw,
+                                  const double *pressure) const
+  {
+    SDH::cDSA::sContactInfo info;
+    info.force = info.area = info.cog_x = info.cog_y = 0.0;
+    int cells = 0;
+    double sum_raw = 0.0, sum_pressure = 0.0, moment_x = 0.0, moment_y = 0.0;
+    for (int y = 0, i = 0; y < frame.cells_y[m]; y++)
+    {
+      for (int x = 0; x < frame.cells_x[m]; x++, i++)
+      {
+        if (raw[i] <= contact_area_threshold_)
+          continue;
+        ++cells;
+        sum_raw += raw[i];
+        sum_pressure += pressure[i];
+        moment_x += x * raw[i];
+        moment_y += y * raw[i];
+      }
+    }
+    if (cells == 0 || sum_raw < contact_force_threshold_)
+      return info;
+    const double cell_area = frame.texel_width[m] * frame.texel_height[m];  // [mm^2]
+    info.cog_x = frame.texel_width[m] * moment_x / sum_raw;
+    info.cog_y = frame.texel_height[m] * moment_y / sum_raw;
+    info.area = cells * cell_area;
+    info.force = sum_pressure * cell_area * 1e-6;
+    return info;
+  }
+
+  /// builds the calibration tables and name tables for the layout of \a frame
+  void prepare(const DsaFrame &frame)
+  {
+    std::string error;
+    if (!calibration_.prepare(frame.offset, error))
+    {
+      ROS_ERROR("dsa_calibration does not fit the sensor (%s), using dsa_calib_pressure/dsa_calib_voltage",
+                error.c_str());
+      calibration_.configure(std::vector<double>(1, default_gain_), std::vector<double>(), std::vector<double>(),
+                             std::vector<double>(), error);
+      calibration_.prepare(frame.offset, error);
+    }
+
+    static const std::string finger_names[3] = {"finger_2", "thumb_", "finger_1"};
+    sensor_names_.assign(frame.matrices(), std::string());
+    for (int fi = 0; fi < 3; fi++)
+    {
+      for (int part = 0; part < 2; part++)
+      {
+        const int mid = frame.matrix_index[2 * fi + part];
+        if (mid >= 0 && mid < static_cast<int>(frame.matrices()))
+          sensor_names_[mid] = "sdh_" + finger_names[fi] + std::to_string(part + 2) + "_link";
+      }
+    }
+
+    message_of_matrix_.assign(frame.matrices(), -1);
+    for (size_t i = 0; i < reorder_.size(); i++)
+    {
+      if (reorder_[i] >= 0 && reorder_[i] < static_cast<int>(frame.matrices()))
+        message_of_matrix_[reorder_[i]] = i;
+    }
+
+    size_t largest = 0;
+    for (size_t m = 0; m < frame.matrices(); m++)
+      largest = std::max(largest, frame.offset[m + 1] - frame.offset[m]);
+    scratch_.resize(largest);
+    segmenter_.reserve(largest);
+  }
+
+  PressureCalibration calibration_;
+  double default_gain_;
+  std::vector<int> reorder_;
+  std::vector<int> message_of_matrix_;     // index in the TactileSensor message of each matrix, -1 if not published
+  std::vector<std::string> sensor_names_;  // PressureArray name of each matrix
+  std::vector<double> scratch_;            // pressures of one matrix if they are not published
+  ContactSegmenter segmenter_;
+  double contact_area_threshold_;
+  double contact_force_threshold_;
+  bool decoded_;
+  uint32_t timestamp_;  // sensor timestamp of the last decoded frame
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TACTILE_DECODER_H
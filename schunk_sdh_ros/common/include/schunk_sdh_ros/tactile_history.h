@@ -0,0 +1,220 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TACTILE_HISTORY_H
+#define SCHUNK_SDH_ROS_TACTILE_HISTORY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+
+#include <schunk_sdh_ros/dsa_frame.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief The last frames of the sensor in a fixed ring buffer.
+ *
+ * The texels of each slot are stored in the layout of DsaFrame, so recording a frame is one copy. The storage for all
+ * slots is allocated with the first frame and again only if the sensor reports a different layout, which also clears
+ * the history. Frames are identified by their sensor timestamp and the acquisition time estimated from it.
+ */
+class TactileHistory
+{
+public:
+  explicit TactileHistory(size_t capacity = 0) :
+      capacity_(capacity), cells_(0), first_(0), size_(0)
+  {
+  }
+
+  /// number of frames kept, clears the history
+  void setCapacity(size_t capacity)
+  {
+    capacity_ = capacity;
+    cells_ = 0;
+    clear();
+  }
+
+  size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  /// number of frames recorded, at most capacity()
+  size_t size() const
+  {
+    return size_;
+  }
+
+  void clear()
+  {
+    first_ = 0;
+    size_ = 0;
+  }
+
+  /// acquisition time of the newest frame, zero if empty
+  ros::Time newest() const
+  {
+    return size_ ? stamps_[slot(size_ - 1)] : ros::Time();
+  }
+
+  /// replaces the oldest frame by \a frame
+  void record(const DsaFrame &frame)
+  {
+    if (capacity_ == 0)
+      return;
+    if (cells_ != frame.texels.size() || cells_x_ != frame.cells_x || cells_y_ != frame.cells_y)
+      allocate(frame);
+
+    size_t s;
+    if (size_ < capacity_)
+    {
+      s = slot(size_++);
+    }
+    else
+    {
+      s = first_;
+      first_ = (first_ + 1) % capacity_;
+    }
+    stamps_[s] = frame.stamp;
+    timestamps_[s] = frame.timestamp;
+    std::copy(frame.texels.begin(), frame.texels.end(), texels_.begin() + s * cells_);
+  }
+
+  /*!
+   * \brief Copies the frames acquired between \a start and \a end into \a history.
+   *
+   * \a history takes over the layout, it allocates only if its capacity or the layout changed.
+   * \return number of frames copied
+   */
+  size_t copyWindow(const ros::Time &start, const ros::Time &end, TactileHistory &history) const
+  {
+    history.clear();
+    if (history.cells_ != cells_ || history.cells_x_ != cells_x_ || history.cells_y_ != cells_y_)
+    {
+      history.cells_x_ = cells_x_;
+      history.cells_y_ = cells_y_;
+      history.offset_ = offset_;
+      history.cells_ = cells_;
+      history.stamps_.resize(history.capacity_);
+      history.timestamps_.resize(history.capacity_);
+      history.texels_.resize(history.capacity_ * cells_);
+    }
+    for (size_t k = 0; k < size_ && history.size_ < history.capacity_; k++)
+    {
+      const size_t s = slot(k);
+      if (stamps_[s] < start || stamps_[s] > end)
+        continue;
+      const size_t d = history.size_++;
+      history.stamps_[d] = stamps_[s];
+      history.timestamps_[d] = timestamps_[s];
+      std::copy(texels_.begin() + s * cells_, texels_.begin() + (s + 1) * cells_,
+                history.texels_.begin() + d * cells_);
+    }
+    return history.size_;
+  }
+
+  /*!
+   * \brief Writes the frames acquired between \a start and \a end into a GetTactileHistory response.
+   *
+   * \param start, end window, both included, zero times stand for the oldest and the newest frame
+   * \param order SDHLibrary matrix of each matrix in the response, like the reorder of tactile_data
+   * \param res receives cells_x, cells_y, stamp, timestamp and texels, oldest frame first
+   * \return number of frames written
+   */
+  template<typename Response>
+  size_t extract(const ros::Time &start, const ros::Time &end, const std::vector<int> &order, Response &res) const
+  {
+    res.cells_x.clear();
+    res.cells_y.clear();
+    res.stamp.clear();
+    res.timestamp.clear();
+    res.texels.clear();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+      if (order[i] < 0 || order[i] >= static_cast<int>(cells_x_.size()))
+        return 0;
+      res.cells_x.push_back(cells_x_[order[i]]);
+      res.cells_y.push_back(cells_y_[order[i]]);
+    }
+
+    size_t frames = 0;
+    for (size_t k = 0; k < size_; k++)
+    {
+      const size_t s = slot(k);
+      if ((!start.isZero() && stamps_[s] < start) || (!end.isZero() && stamps_[s] > end))
+        continue;
+      ++frames;
+    }
+    res.stamp.reserve(frames);
+    res.timestamp.reserve(frames);
+    res.texels.reserve(frames * cells_);
+
+    for (size_t k = 0; k < size_; k++)
+    {
+      const size_t s = slot(k);
+      if ((!start.isZero() && stamps_[s] < start) || (!end.isZero() && stamps_[s] > end))
+        continue;
+      res.stamp.push_back(stamps_[s]);
+      res.timestamp.push_back(timestamps_[s]);
+      const SDH::cDSA::tTexel *texels = texels_.data() + s * cells_;
+      for (size_t i = 0; i < order.size(); i++)
+        res.texels.insert(res.texels.end(), texels + offset_[order[i]], texels + offset_[order[i] + 1]);
+    }
+    return frames;
+  }
+
+private:
+  void allocate(const DsaFrame &frame)
+  {
+    cells_x_ = frame.cells_x;
+    cells_y_ = frame.cells_y;
+    offset_ = frame.offset;
+    cells_ = frame.texels.size();
+    stamps_.assign(capacity_, ros::Time());
+    timestamps_.assign(capacity_, 0);
+    texels_.assign(capacity_ * cells_, 0);
+    clear();
+  }
+
+  /// slot of the k-th oldest frame
+  size_t slot(size_t k) const
+  {
+    return (first_ + k) % capacity_;
+  }
+
+  size_t capacity_;
+  // layout of all frames, see DsaFrame
+  std::vector<uint16_t> cells_x_;
+  std::vector<uint16_t> cells_y_;
+  std::vector<size_t> offset_;
+  size_t cells_;  // texels per frame
+
+  size_t first_;  // slot of the oldest frame
+  size_t size_;
+  std::vector<ros::Time> stamps_;
+  std::vector<uint32_t> timestamps_;
+  std::vector<SDH::cDSA::tTexel> texels_;  // capacity_ frames of cells_ texels
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TACTILE_HISTORY_H
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TACTILE_REFLEX_H
+#define SCHUNK_SDH_ROS_TACTILE_REFLEX_H
+
+#include <vector>
+
+#include <schunk_sdh/dsa.h>
+
+#include <schunk_sdh_ros/tactile_decoder.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Force thresholds per tactile matrix that trip a stop of the hand.
+ *
+ * The reflex trips once when a matrix exceeds its threshold and re-arms only after all matrices dropped below their
+ * thresholds again. So holding an object that still presses a matrix does not stop every following command, and the
+ * hand can be opened again right away.
+ */
+class TactileReflex
+{
+public:
+  TactileReflex() :
+      armed_(true)
+  {
+  }
+
+  /// force threshold of each matrix in the order of tactile_data [N], 0 or negative disables a matrix
+  void setThresholds(const std::vector<double> &thresholds)
+  {
+    thresholds_ = thresholds;
+    armed_ = true;
+  }
+
+  /// true if any matrix has a threshold
+  bool enabled() const
+  {
+    for (size_t i = 0; i < thresholds_.size(); i++)
+    {
+      if (thresholds_[i] > 0.0)
+        return true;
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Checks the contacts of one frame.
+   *
+   * \param contacts contact of each matrix, SDHLibrary matrix order
+   * \param decoder maps SDHLibrary matrices to the order of tactile_data
+   * \return matrix in the order of tactile_data that tripped the reflex, -1 if it did not trip
+   */
+  int check(const std::vector<SDH::cDSA::sContactInfo> &contacts, const TactileDecoder &decoder)
+  {
+    int tripped = -1;
+    bool above = false;
+    for (size_t m = 0; m < contacts.size(); m++)
+    {
+      const int i = decoder.messageIndex(m);
+      if (i < 0 || i >= static_cast<int>(thresholds_.size()) || thresholds_[i] <= 0.0)
+        continue;
+      if (contacts[m].force > thresholds_[i])
+      {
+        above = true;
+        if (tripped < 0)
+          tripped = i;
+      }
+    }
+    if (!above)
+    {
+      armed_ = true;
+      return -1;
+    }
+    if (!armed_)
+      return -1;
+    armed_ = false;
+    return tripped;
+  }
+
+private:
+  std::vector<double> thresholds_;  // [N]
+  bool armed_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TACTILE_REFLEX_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TRAJECTORY_SAMPLER_H
+#define SCHUNK_SDH_ROS_TRAJECTORY_SAMPLER_H
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <trajectory_msgs/JointTrajectory.h>
+
+#include <schunk_sdh_ros/joint_mapping.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Samples a JointTrajectory in SDH axis order with cubic Hermite splines.
+ *
+ * Points without velocities get Catmull-Rom tangents (central differences), the first and last point are reached at
+ * rest. If the first point does not start at time 0, the trajectory starts from the given current position. Knots
+ * are stored point by point with all axes contiguous, so sampling is one tight loop over the axes.
+ */
+class TrajectorySampler
+{
+public:
+  TrajectorySampler() :
+      axes_(0), segment_(0)
+  {
+  }
+
+  /*!
+   * \brief Converts a trajectory into knots in axis order [deg, deg/s].
+   *
+   * \param trajectory trajectory of the goal
+   * \param index_of_axis index of each axis in the joint names of the trajectory, see JointMapping::indexOfAxes()
+   * \param start current position in axis order [deg]
+   * \param error receives a description if the trajectory is malformed
+   * \return true on success
+   */
+  bool init(const trajectory_msgs::JointTrajectory &trajectory, const std::vector<int> &index_of_axis,
+            const std::vector<double> &start, std::string &error)
+  {
+    axes_ = index_of_axis.size();
+    segment_ = 0;
+    times_.clear();
+    positions_.clear();
+    velocities_.clear();
+    if (start.size() != axes_)
+    {
+      error = "no valid start position";
+      return false;
+    }
+
+    const std::vector<trajectory_msgs::JointTrajectoryPoint> &points = trajectory.points;
+    if (points.empty() || points[0].time_from_start.toSec() > 0.0)
+    {
+      times_.push_back(0.0);
+      positions_.insert(positions_.end(), start.begin(), start.end());
+      velocities_.insert(velocities_.end(), axes_, 0.0);
+    }
+
+    const double unknown = std::numeric_limits<double>::quiet_NaN();
+    for (size_t k = 0; k < points.size(); k++)
+    {
+      const trajectory_msgs::JointTrajectoryPoint &point = points[k];
+      const double t = point.time_from_start.toSec();
+      if (point.positions.size() != trajectory.joint_names.size())
+      {
+        error = "point " + std::to_string(k) + " has " + std::to_string(point.positions.size()) + " positions";
+        return false;
+      }
+      if (!times_.empty() && t <= times_.back())
+      {
+        error = "time_from_start of point " + std::to_string(k) + " is not increasing";
+        return false;
+      }
+      const bool has_velocities = point.velocities.size() == point.positions.size();
+      times_.push_back(t);
+      for (size_t a = 0; a < axes_; a++)
+      {
+        positions_.push_back(point.positions[index_of_axis[a]] * kDegPerRad);
+        velocities_.push_back(has_velocities ? point.velocities[index_of_axis[a]] * kDegPerRad : unknown);
+      }
+    }
+
+    // missing velocities: rest at the ends, central differences in between
+    const size_t n = times_.size();
+    for (size_t k = 0; k < n; k++)
+    {
+      for (size_t a = 0; a < axes_; a++)
+      {
+        double &v = velocities_[k * axes_ + a];
+        if (v == v)
+          continue;
+        if (k == 0 || k == n - 1)
+          v = 0.0;
+        else
+          v = (positions_[(k + 1) * axes_ + a] - positions_[(k - 1) * axes_ + a]) / (times_[k + 1] - times_[k - 1]);
+      }
+    }
+    return true;
+  }
+
+  /// number of axes
+  size_t size() const
+  {
+    return axes_;
+  }
+
+  /// time of the last point [s]
+  double duration() const
+  {
+    return times_.empty() ? 0.0 : times_.back();
+  }
+
+  /// final position of axis \a axis [deg]
+  double finalPosition(size_t axis) const
+  {
+    return positions_[(times_.size() - 1) * axes_ + axis];
+  }
+
+  /*!
+   * \brief Samples the trajectory.
+   *
+   * Before the first and after the last point the respective point is held at rest. Sampling is fastest close to the
+   * previous \a t, as the segment search continues from the previous call in either direction.
+   * \param t time since the start of the trajectory [s]
+   * \param position receives size() positions [deg]
+   * \param velocity receives size() velocities [deg/s]
+   */
+  void sample(double t, double *position, double *velocity)
+  {
+    const size_t n = times_.size();
+    if (n == 0)
+      return;
+    if (t <= times_[0] || t >= times_[n - 1])
+    {
+      const size_t k = (t <= times_[0]) ? 0 : n - 1;
+      for (size_t a = 0; a < axes_; a++)
+      {
+        position[a] = positions_[k * axes_ + a];
+        velocity[a] = 0.0;
+      }
+      return;
+    }
+
+    while (segment_ > 0 && t < times_[segment_])
+      --segment_;
+    while (segment_ + 2 < n && t >= times_[segment_ + 1])
+      ++segment_;
+
+    const double h = times_[segment_ + 1] - times_[segment_];
+    const double s = (t - times_[segment_]) / h;
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    // Hermite basis and its derivative with respect to s
+    const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    const double h10 = (s3 - 2.0 * s2 + s) * h;
+    const double h01 = -2.0 * s3 + 3.0 * s2;
+    const double h11 = (s3 - s2) * h;
+    const double d00 = (6.0 * s2 - 6.0 * s) / h;
+    const double d10 = 3.0 * s2 - 4.0 * s + 1.0;
+    const double d01 = (-6.0 * s2 + 6.0 * s) / h;
+    const double d11 = 3.0 * s2 - 2.0 * s;
+
+    const double *p0 = &positions_[segment_ * axes_];
+    const double *p1 = p0 + axes_;
+    const double *v0 = &velocities_[segment_ * axes_];
+    const double *v1 = v0 + axes_;
+    for (size_t a = 0; a < axes_; a++)
+    {
+      position[a] = h00 * p0[a] + h10 * v0[a] + h01 * p1[a] + h11 * v1[a];
+      velocity[a] = d00 * p0[a] + d10 * v0[a] + d01 * p1[a] + d11 * v1[a];
+    }
+  }
+
+private:
+  size_t axes_;
+  std::vector<double> times_;       // [s]
+  std::vector<double> positions_;   // point-major, [deg]
+  std::vector<double> velocities_;  // point-major, [deg/s]
+  size_t segment_;                  // segment of the previous sample
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TRAJECTORY_SAMPLER_H
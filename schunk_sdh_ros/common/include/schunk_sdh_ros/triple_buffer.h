@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TRIPLE_BUFFER_H
+#define SCHUNK_SDH_ROS_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Lock-free snapshot exchange between one producer and one consumer thread.
+ *
+ * The producer fills its private slot and swaps it in with a single atomic exchange, the consumer swaps out the
+ * newest complete snapshot the same way. Neither side ever waits for the other and the consumer never sees a
+ * partially written value.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+  TripleBuffer() :
+      shared_(1), write_(0), read_(2)
+  {
+  }
+
+  /*!
+   * \brief Initializes all slots with the same value, e.g. to preallocate vectors.
+   *
+   * Not thread-safe, call before producer and consumer are running.
+   */
+  void reset(const T &value)
+  {
+    for (int i = 0; i < 3; i++)
+      buffers_[i] = value;
+    shared_ = 1;
+    write_ = 0;
+    read_ = 2;
+  }
+
+  /// slot owned by the producer, fill it and call publish()
+  T &writeBuffer()
+  {
+    return buffers_[write_];
+  }
+
+  /// hands the producer slot over to the consumer
+  void publish()
+  {
+    write_ = shared_.exchange(write_ | kDirty, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  void write(const T &value)
+  {
+    writeBuffer() = value;
+    publish();
+  }
+
+  /*!
+   * \brief Fetches the newest snapshot into the consumer slot.
+   *
+   * \return true if a snapshot was published since the last call
+   */
+  bool update()
+  {
+    if ((shared_.load(std::memory_order_relaxed) & kDirty) == 0)
+      return false;
+    read_ = shared_.exchange(read_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  /// slot owned by the consumer, valid until the next call to update()
+  const T &readBuffer() const
+  {
+    return buffers_[read_];
+  }
+
+  bool read(T &value)
+  {
+    const bool fresh = update();
+    value = readBuffer();
+    return fresh;
+  }
+
+private:
+  static const unsigned int kIndexMask = 0x3;
+  static const unsigned int kDirty = 0x4;
+
+  T buffers_[3];
+  std::atomic<unsigned int> shared_;
+  unsigned int write_;  // only touched by the producer
+  unsigned int read_;   // only touched by the consumer
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TRIPLE_BUFFER_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// ##################
+// #### includes ####
+// ROS includes
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <boost/shared_ptr.hpp>
+
+// package includes
+#include <schunk_sdh_ros/dsa_node.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief DsaNode loaded into a nodelet manager.
+ *
+ * All messages are published as shared pointers to const, so subscribers in the same manager receive the frames
+ * without serialization or copies. The timers run on the single-threaded queue of the private node handle, just like
+ * in the standalone dsa_only node.
+ */
+class DsaNodelet : public nodelet::Nodelet
+{
+private:
+  virtual void onInit()
+  {
+    node_.reset(new DsaNode(getPrivateNodeHandle()));
+    if (!node_->init())
+    {
+      NODELET_ERROR("DSA nodelet could not be initialized, check dsadevicestring and dsa_calibration");
+      node_.reset();
+      return;
+    }
+    node_->start();
+    NODELET_INFO("...dsa nodelet running...");
+  }
+
+  boost::shared_ptr<DsaNode> node_;
+};
+
+}  // namespace schunk_sdh_ros
+
+PLUGINLIB_EXPORT_CLASS(schunk_sdh_ros::DsaNodelet, nodelet::Nodelet)
@@ -19,8 +19,15 @@
 // #### includes ####
 // standard includes
 #include <unistd.h>
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 // ROS includes
@@ -38,6 +45,7 @@
 #include <schunk_sdh/TactileMatrix.h>
 #include <schunk_sdh/TemperatureArray.h>
 #include <schunk_sdh/PressureArrayList.h>
+#include <schunk_sdh_ros/CloseUntilContactAction.h>
 
 // ROS service includes
 #include <std_srvs/Trigger.h>
@@ -45,11 +53,30 @@
 
 // ROS diagnostic msgs
 #include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/KeyValue.h>
 
 // external includes
 #include <schunk_sdh/sdh.h>
 #include <schunk_sdh/dsa.h>
 
+#include <boost/lexical_cast.hpp>
+
+// package includes
+#include <schunk_sdh_ros/axis_snapshot.h>
+#include <schunk_sdh_ros/call_profiler.h>
+#include <schunk_sdh_ros/clock_offset_estimator.h>
+#include <schunk_sdh_ros/command_mailbox.h>
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/feedback_messages.h>
+#include <schunk_sdh_ros/joint_mapping.h>
+#include <schunk_sdh_ros/reusable_message.h>
+#include <schunk_sdh_ros/cycle_stats.h>
+#include <schunk_sdh_ros/signal_scheduler.h>
+#include <schunk_sdh_ros/tactile_decoder.h>
+#include <schunk_sdh_ros/tactile_reflex.h>
+#include <schunk_sdh_ros/trajectory_sampler.h>
+#include <schunk_sdh_ros/triple_buffer.h>
+
 /*!
  * \brief Implementation of ROS node for sdh.
  *
@@ -66,6 +93,7 @@ private:
   ros::Publisher topicPub_ControllerState_;
   ros::Publisher topicPub_TactileSensor_;
   ros::Publisher topicPub_Diagnostics_;
+  ros::Publisher topicPub_CallStats_;
   ros::Publisher topicPub_Temperature_;
   ros::Publisher topicPub_Pressure_;
 
@@ -85,6 +113,7 @@ private:
   // actionlib server
   actionlib::SimpleActionServer<control_msgs::FollowJointTrajectoryAction> as_;
   std::string action_name_;
+  actionlib::SimpleActionServer<schunk_sdh_ros::CloseUntilContactAction> grasp_as_;
 
   // service clients
   // --
@@ -92,7 +121,8 @@ private:
   // other variables
   SDH::cSDH *sdh_;
   SDH::cDSA *dsa_;
-  std::vector<SDH::cSDH::eAxisState> state_;
+  std::mutex sdh_mutex_;  // serialises hardware access of the update loop and the service callbacks
+  std::mutex dsa_mutex_;
 
   std::string sdhdevicetype_;
   std::string sdhdevicestring_;
@@ -106,23 +136,104 @@ private:
   int baudrate_, id_read_, id_write_;
   double timeout_;
 
-  bool isInitialized_;
-  bool isDSAInitialized_;
+  std::atomic<bool> isInitialized_;
+  std::atomic<bool> isDSAInitialized_;
   bool isError_;
   int DOF_;
-  double pi_;
 
   trajectory_msgs::JointTrajectory traj_;
 
   std::vector<std::string> joint_names_;
+  schunk_sdh_ros::JointMapping joint_mapping_;  // joint order <-> axis order
+  std::vector<int> goal_index_of_axis_;  // only used by executeCB
+  schunk_sdh_ros::TrajectorySampler sampler_;  // only used by executeCB
+  schunk_sdh_ros::TripleBuffer<schunk_sdh_ros::StampedAngles> actual_angles_;  // written by updateSdh
+  std::atomic<bool> streaming_;  // executeCB streams setpoints, updateSdh must not stop the hand in between
+  double frequency_;  // rate of updateSdh
+  double trajectory_position_gain_;  // velocity mode streaming: correction of the position error [1/s]
+
+  // end of the motion to a position target, detected by updateSdh and waited for by executeCB
+  std::mutex motion_mutex_;
+  std::condition_variable motion_cond_;
+  uint64_t motion_done_seq_;  // last command whose motion finished, guarded by motion_mutex_
+  std::chrono::steady_clock::time_point motion_done_;  // time the motion finished, guarded by motion_mutex_
+  uint64_t motion_seq_;  // command whose motion is tracked by updateSdh, 0 if none
+  bool motion_started_;  // an axis left idle since the command was delivered
+  std::chrono::steady_clock::time_point motion_delivered_;
+  double position_tolerance_;  // default goal tolerance, in degrees
+  double default_goal_time_tolerance_;  // for streamed goals without goal_time_tolerance [s]
+  schunk_sdh_ros::TripleBuffer<std::vector<double> > goal_tolerance_;  // in degrees, written by executeCB
+  std::vector<double> motion_tolerance_;  // goal tolerance of the tracked motion
+  bool motion_tolerance_checked_;  // any axis of motion_tolerance_ is checked
+  bool motion_done_within_;  // the finished motion ended within the goal tolerance, guarded by motion_mutex_
+  double motion_start_timeout_;  // [s]
+  std::atomic<double> goal_duration_last_;  // goal accepted to result sent [s]
+  std::atomic<double> goal_completion_latency_last_;  // end of motion detected to result sent [s]
+
   std::vector<int> axes_;
   std::vector<double> targetAngles_;  // in degrees
-  std::vector<double> velocities_;  // in rad/s
-  bool hasNewGoal_;
-  std::string operationMode_;
+  std::vector<double> velocities_;  // in deg/s
+  schunk_sdh_ros::AxisSnapshot snapshot_;  // last feedback, only used by the update loop
+  schunk_sdh_ros::SignalScheduler scheduler_;  // rates of the individual feedback signals
+  schunk_sdh_ros::CallProfiler profiler_;  // latencies of the hardware calls, published on call_stats
+  int sig_angles_, sig_velocities_, sig_state_, sig_temperature_, sig_diagnostics_;
+  schunk_sdh_ros::CommandMailbox<std::vector<double> > command_;  // target angles or velocities in axis order
+  schunk_sdh_ros::FeedbackMessages feedbackMsgs_;  // published messages, reused once roscpp released them
+  std::string operationMode_;  // written under sdh_mutex_ and mode_mutex_, read with either held
+  std::mutex mode_mutex_;
+
+  // threaded mode: SDH and DSA loops run on their own threads, callbacks on an AsyncSpinner
+  bool threaded_;
+  std::atomic<bool> running_;
+  std::thread sdh_thread_;
+  std::thread dsa_thread_;
+  schunk_sdh_ros::CycleStats sdh_stats_;
+  schunk_sdh_ros::CycleStats dsa_stats_;
+
+  // tactile frames are read continuously by their own thread, updateDsa() only publishes the newest one
+  std::atomic<bool> dsa_reader_running_;
+  std::thread dsa_reader_thread_;
+  schunk_sdh_ros::TripleBuffer<schunk_sdh_ros::DsaFrame> dsa_frames_;
+  std::atomic<uint64_t> dsa_frames_read_;
+  std::atomic<uint64_t> dsa_read_errors_;
+  schunk_sdh_ros::ClockOffsetEstimator dsa_clock_;  // sensor timestamps to ROS time, guarded by dsa_mutex_
+  schunk_sdh_ros::TactileDecoder tactile_decoder_;  // only used by updateDsa
+  schunk_sdh_ros::ReusableMessage<schunk_sdh::TactileSensor> tactileMsg_;
+  schunk_sdh_ros::ReusableMessage<schunk_sdh::PressureArrayList> pressureMsg_;
+
+  // contacts decoded by the reader thread for the reflex and the grasp
+  schunk_sdh_ros::TactileDecoder contact_decoder_;  // only used by readDsaLoop
+  std::vector<SDH::cDSA::sContactInfo> contacts_;  // only used by readDsaLoop
+  std::atomic<uint32_t> finger_contact_;  // bit f: a matrix of finger f is in contact in the newest frame
+
+  // tactile reflex: checked by the reader thread on every frame, executed by updateSdh on its next cycle
+  schunk_sdh_ros::TactileReflex reflex_;  // only used by readDsaLoop
+  bool reflex_enabled_;
+  std::atomic<uint64_t> reflex_trips_;  // number of times the reflex tripped
+  uint64_t reflex_executed_;  // trips executed by updateSdh
+  std::mutex reflex_mutex_;
+  ros::Time reflex_frame_stamp_;  // acquisition time of the tripping frame, guarded by reflex_mutex_
+  std::chrono::steady_clock::time_point reflex_detected_;  // guarded by reflex_mutex_
+  int reflex_matrix_;  // matrix in the order of tactile_data, guarded by reflex_mutex_
+  double reflex_latency_last_;  // detection to stop command sent [s], only used by updateSdh
+  double reflex_latency_max_;   // since the last diagnostics [s]
+  double reflex_acquisition_latency_last_;  // acquisition of the frame to stop command sent [s]
+
+  // close until contact: requested by graspCB, run by updateSdh on every cycle
+  std::atomic<bool> grasp_sense_;  // readDsaLoop keeps finger_contact_ up to date
+  std::atomic<bool> grasp_requested_;
+  std::mutex grasp_mutex_;
+  std::condition_variable grasp_cond_;
+  uint64_t grasp_seq_;  // requested grasp, guarded by grasp_mutex_
+  double grasp_velocity_;  // [deg/s], guarded by grasp_mutex_
+  uint64_t grasp_ended_seq_;  // last grasp updateSdh ended, guarded by grasp_mutex_
+  uint32_t grasp_stopped_;  // bit f: finger f stopped at contact, guarded by grasp_mutex_
+  std::chrono::steady_clock::time_point grasp_stop_time_[3];  // guarded by grasp_mutex_
+  uint64_t grasp_running_;  // grasp run by updateSdh, 0 if none, only used by updateSdh
+  uint32_t grasp_running_stopped_;  // only used by updateSdh
+  static const std::vector<std::string> finger_names_;
 
   static const std::vector<std::string> temperature_names_;
-  static const std::vector<std::string> finger_names_;
 
 public:
   /*!
@@ -131,14 +242,48 @@ public:
    * \param name Name for the actionlib server
    */
   SdhNode(std::string name) :
-      as_(nh_, name, boost::bind(&SdhNode::executeCB, this, _1), true), action_name_(name)
+      as_(nh_, name, boost::bind(&SdhNode::executeCB, this, _1), true), action_name_(name),
+      grasp_as_(nh_, ros::this_node::getName() + "/close_until_contact", boost::bind(&SdhNode::graspCB, this, _1),
+                true)
   {
-    pi_ = 3.1415926;
 
     nh_ = ros::NodeHandle("~");
     isError_ = false;
+    as_.registerPreemptCallback(boost::bind(&SdhNode::preemptCB, this));
+    grasp_as_.registerPreemptCallback(boost::bind(&SdhNode::graspPreemptCB, this));
+    streaming_ = false;
+    frequency_ = 100.0;
+    motion_done_seq_ = 0;
+    motion_seq_ = 0;
+    motion_started_ = false;
+    motion_tolerance_checked_ = false;
+    motion_done_within_ = false;
+    goal_duration_last_ = 0.0;
+    goal_completion_latency_last_ = 0.0;
+    threaded_ = false;
+    running_ = false;
+    dsa_reader_running_ = false;
+    dsa_frames_read_ = 0;
+    dsa_read_errors_ = 0;
+    finger_contact_ = 0;
+    grasp_sense_ = false;
+    grasp_requested_ = false;
+    grasp_seq_ = 0;
+    grasp_velocity_ = 0.0;
+    grasp_ended_seq_ = 0;
+    grasp_stopped_ = 0;
+    grasp_running_ = 0;
+    grasp_running_stopped_ = 0;
+    reflex_enabled_ = false;
+    reflex_trips_ = 0;
+    reflex_executed_ = 0;
+    reflex_matrix_ = -1;
+    reflex_latency_last_ = 0.0;
+    reflex_latency_max_ = 0.0;
+    reflex_acquisition_latency_last_ = 0.0;
     // diagnostics
     topicPub_Diagnostics_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    topicPub_CallStats_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("call_stats", 1);
   }
 
   /*!
@@ -146,6 +291,7 @@ public:
    */
   ~SdhNode()
   {
+    stopThreads();
     if (isDSAInitialized_)
       dsa_->Close();
     if (isInitialized_)
@@ -161,7 +307,6 @@ public:
     // initialize member variables
     isInitialized_ = false;
     isDSAInitialized_ = false;
-    hasNewGoal_ = false;
 
     // implementation of topics to publish
     topicPub_JointState_ = nh_.advertise<sensor_msgs::JointState>("joint_states", 1);
@@ -200,6 +345,32 @@ public:
     nh_.param("dsa_sensitivity", dsa_sensitivity_, 0.5);
     nh_.param("dsa_calib_pressure", dsa_calib_pressure_, 0.000473); // unit: N/(mm*mm)
     nh_.param("dsa_calib_voltage", dsa_calib_voltage_, 592.1);      // unit: mV
+    // SDHLibrary matrix of each matrix of tactile_data, and the contact thresholds, like the DSA node
+    std::vector<int> dsa_reorder;
+    nh_.param("dsa_reorder", dsa_reorder, std::vector<int>({2, 3, 4, 5, 0, 1}));  // t1,t2,f11,f12,f21,f22
+    double contact_area_threshold, contact_force_threshold;
+    nh_.param("contact_area_cell_threshold", contact_area_threshold, 10.0);
+    nh_.param("contact_force_cell_threshold", contact_force_threshold, 10.0);
+    std::string calibration_error;
+    if (!tactile_decoder_.loadCalibration(nh_, "dsa_calibration", defaultPressureGain(), calibration_error))
+    {
+      ROS_ERROR("Parameter dsa_calibration invalid (%s), shutting down node...", calibration_error.c_str());
+      nh_.shutdown();
+      return false;
+    }
+    tactile_decoder_.setReorder(dsa_reorder);
+    tactile_decoder_.setContactThresholds(contact_area_threshold, contact_force_threshold);
+
+    // tactile reflex, force thresholds in the matrix order of tactile_data
+    std::vector<double> reflex_thresholds;
+    nh_.getParam("reflex_force_thresholds", reflex_thresholds);
+    reflex_.setThresholds(reflex_thresholds);
+    reflex_enabled_ = reflex_.enabled();
+    if (reflex_enabled_)
+      ROS_INFO("tactile reflex enabled");
+    contact_decoder_.loadCalibration(nh_, "dsa_calibration", defaultPressureGain(), calibration_error);
+    contact_decoder_.setReorder(dsa_reorder);
+    contact_decoder_.setContactThresholds(contact_area_threshold, contact_force_threshold);
 
     nh_.param("baudrate", baudrate_, 1000000);
     nh_.param("timeout", timeout_, static_cast<double>(0.04));
@@ -226,6 +397,13 @@ public:
       joint_names_[i] = (std::string)joint_names_param[i];
     }
     std::cout << "joint_names = " << joint_names_param << std::endl;
+    std::string mapping_error;
+    if (!joint_mapping_.init(joint_names_, mapping_error))
+    {
+      ROS_ERROR("Parameter joint_names invalid (%s), shutting down node...", mapping_error.c_str());
+      nh_.shutdown();
+      return false;
+    }
 
     // define axes to send to sdh
     axes_.resize(DOF_);
@@ -236,9 +414,20 @@ public:
     }
     ROS_INFO("DOF = %d", DOF_);
 
-    state_.resize(axes_.size());
+    command_.reset(std::vector<double>(DOF_));
+    schunk_sdh_ros::StampedAngles stamped_angles;
+    stamped_angles.angles.resize(DOF_);
+    actual_angles_.reset(stamped_angles);
+
+    feedbackMsgs_.reset(joint_mapping_, joint_names_, temperature_names_);
 
     nh_.param("OperationMode", operationMode_, std::string("position"));
+    nh_.param("trajectory_position_gain", trajectory_position_gain_, 2.0);
+    nh_.param("position_tolerance", position_tolerance_, 0.01);  // in rad
+    position_tolerance_ *= schunk_sdh_ros::kDegPerRad;
+    nh_.param("motion_start_timeout", motion_start_timeout_, 0.5);
+    nh_.param("goal_time_tolerance", default_goal_time_tolerance_, 1.0);
+    goal_tolerance_.reset(std::vector<double>(DOF_, position_tolerance_));
     return true;
   }
   /*!
@@ -248,17 +437,22 @@ public:
    */
   bool switchOperationMode(const std::string &mode)
   {
-    hasNewGoal_ = false;
-    sdh_->Stop();
+    command_.discard();
+    {
+      schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_STOP);
+      sdh_->Stop();
+    }
 
     try
     {
       if (mode == "position")
       {
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_CONTROLLER);
         sdh_->SetController(SDH::cSDH::eCT_POSE);
       }
       else if (mode == "velocity")
       {
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_CONTROLLER);
         sdh_->SetController(SDH::cSDH::eCT_VELOCITY);
       }
       else
@@ -275,10 +469,24 @@ public:
       return false;
     }
 
-    operationMode_ = mode;
+    setOperationMode(mode);
     return true;
   }
 
+  /// copy of the operation mode for callbacks that do not hold sdh_mutex_
+  std::string operationMode()
+  {
+    std::lock_guard<std::mutex> lock(mode_mutex_);
+    return operationMode_;
+  }
+
+  /// call with sdh_mutex_ held
+  void setOperationMode(const std::string &mode)
+  {
+    std::lock_guard<std::mutex> lock(mode_mutex_);
+    operationMode_ = mode;
+  }
+
   /*!
    * \brief Executes the callback from the actionlib
    *
@@ -288,9 +496,11 @@ public:
   void executeCB(const control_msgs::FollowJointTrajectoryGoalConstPtr &goal)
   {
     ROS_INFO("sdh: executeCB");
-    if (operationMode_ != "position")
+    control_msgs::FollowJointTrajectoryResult result;
+    const std::string mode = operationMode();
+    if (mode != "position" && mode != "velocity")
     {
-      ROS_ERROR("%s: Rejected, sdh not in position mode", action_name_.c_str());
+      ROS_ERROR("%s: Rejected, sdh neither in position nor in velocity mode", action_name_.c_str());
       as_.setAborted();
       return;
     }
@@ -301,75 +511,596 @@ public:
       return;
     }
 
-    if (goal->trajectory.points.empty() || goal->trajectory.points[0].positions.size() != size_t(DOF_))
+    if (goal->trajectory.points.empty()
+        || goal->trajectory.points[0].positions.size() != goal->trajectory.joint_names.size())
     {
       ROS_ERROR("%s: Rejected, malformed FollowJointTrajectoryGoal", action_name_.c_str());
-      as_.setAborted();
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = "malformed FollowJointTrajectoryGoal";
+      as_.setAborted(result);
+      return;
+    }
+    // the goal tolerance defaults to position_tolerance, path tolerances are off unless given
+    std::vector<double> goal_tolerance, path_tolerance;
+    if (!joint_mapping_.indexOfAxes(goal->trajectory.joint_names, goal_index_of_axis_)
+        || !axisTolerances(goal->goal_tolerance, position_tolerance_, goal_tolerance)
+        || !axisTolerances(goal->path_tolerance, -1.0, path_tolerance))
+    {
+      ROS_ERROR("%s: Rejected, joint names of the goal do not match joint_names", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_JOINTS;
+      result.error_string = "joint names do not match joint_names";
+      as_.setAborted(result);
       return;
     }
-    while (hasNewGoal_ == true)
-      usleep(10000);
+    const double goal_time_tolerance = goal->goal_time_tolerance.toSec();
 
-    std::map<std::string, int> dict;
-    for (int idx = 0; idx < goal->trajectory.joint_names.size(); idx++)
+    // timed or multi-point trajectories are streamed, a single untimed point goes to the hand's own controller
+    if (goal->trajectory.points.size() > 1 || !goal->trajectory.points[0].time_from_start.isZero())
+    {
+      streamTrajectory(goal->trajectory, goal_tolerance, path_tolerance,
+                       goal_time_tolerance > 0.0 ? goal_time_tolerance : default_goal_time_tolerance_);
+      return;
+    }
+    if (mode != "position")
     {
-      dict[goal->trajectory.joint_names[idx]] = idx;
+      ROS_ERROR("%s: Rejected, a single point without time_from_start needs position mode", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = "a single point without time_from_start needs position mode";
+      as_.setAborted(result);
+      return;
     }
 
-    targetAngles_.resize(DOF_);
-    targetAngles_[0] = goal->trajectory.points[0].positions[dict["sdh_knuckle_joint"]] * 180.0 / pi_;  // sdh_knuckle_joint
-    targetAngles_[1] = goal->trajectory.points[0].positions[dict["sdh_finger_22_joint"]] * 180.0 / pi_;  // sdh_finger22_joint
-    targetAngles_[2] = goal->trajectory.points[0].positions[dict["sdh_finger_23_joint"]] * 180.0 / pi_;  // sdh_finger23_joint
-    targetAngles_[3] = goal->trajectory.points[0].positions[dict["sdh_thumb_2_joint"]] * 180.0 / pi_;  // sdh_thumb2_joint
-    targetAngles_[4] = goal->trajectory.points[0].positions[dict["sdh_thumb_3_joint"]] * 180.0 / pi_;  // sdh_thumb3_joint
-    targetAngles_[5] = goal->trajectory.points[0].positions[dict["sdh_finger_12_joint"]] * 180.0 / pi_;  // sdh_finger12_joint
-    targetAngles_[6] = goal->trajectory.points[0].positions[dict["sdh_finger_13_joint"]] * 180.0 / pi_;  // sdh_finger13_joint
+    std::vector<double> targetAngles(DOF_);
+    schunk_sdh_ros::JointMapping::gather(goal->trajectory.points[0].positions.data(), goal_index_of_axis_,
+                                         targetAngles.data());
+    schunk_sdh_ros::JointMapping::scale(targetAngles.data(), targetAngles.size(), schunk_sdh_ros::kDegPerRad);
     ROS_INFO(
-        "received position goal: [['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']] = [%f,%f,%f,%f,%f,%f,%f]",
-        goal->trajectory.points[0].positions[dict["sdh_knuckle_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_thumb_2_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_thumb_3_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_12_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_13_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_22_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_23_joint"]]);
+        "received position goal: [knuckle, finger22, finger23, thumb2, thumb3, finger12, finger13] = [%f,%f,%f,%f,%f,%f,%f] deg",
+        targetAngles[0], targetAngles[1], targetAngles[2], targetAngles[3], targetAngles[4], targetAngles[5],
+        targetAngles[6]);
+
+    // handed to updateSdh together with the command, which publishes the buffer
+    goal_tolerance_.write(goal_tolerance);
+    const std::chrono::steady_clock::time_point goal_start = std::chrono::steady_clock::now();
+    const uint64_t reflex_trips = reflex_trips_;
+    const uint64_t seq = command_.post(targetAngles);
+
+    // updateSdh reports the end of the motion, preemption wakes us up as well
+    // without a goal_time_tolerance the goal waits until the hand comes to rest
+    const std::chrono::steady_clock::time_point deadline =
+        goal_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(goal_time_tolerance));
+    std::unique_lock<std::mutex> lock(motion_mutex_);
+    while (motion_done_seq_ < seq)
+    {
+      if (as_.isPreemptRequested() || !ros::ok())
+      {
+        lock.unlock();
+        holdPosition(false);  // the fingers must not keep moving to the cancelled target
+        ROS_WARN("%s: Preempted", action_name_.c_str());
+        as_.setPreempted();
+        return;
+      }
+      if (command_.discarded(seq) || !isInitialized_)
+      {
+        lock.unlock();
+        result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+        result.error_string = isInitialized_ ? "replaced by another command" : "sdh disconnected";
+        ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+        as_.setAborted(result);
+        return;
+      }
+      const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (goal_time_tolerance > 0.0 && now >= deadline)
+      {
+        lock.unlock();
+        ROS_WARN("%s: Aborted, goal not reached within goal_time_tolerance", action_name_.c_str());
+        result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+        result.error_string = "goal not reached within goal_time_tolerance";
+        as_.setAborted(result);
+        return;
+      }
+      std::chrono::steady_clock::time_point wakeup = now + std::chrono::milliseconds(100);
+      if (goal_time_tolerance > 0.0 && deadline < wakeup)
+        wakeup = deadline;
+      motion_cond_.wait_until(lock, wakeup);
+    }
+    const std::chrono::steady_clock::time_point motion_done = motion_done_;
+    const bool within = motion_done_within_;
+    lock.unlock();
+
+    if (reflex_trips_ != reflex_trips)
+    {
+      ROS_WARN("%s: Aborted, stopped by the tactile reflex", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+      result.error_string = "stopped by the tactile reflex";
+      as_.setAborted(result);
+      return;
+    }
 
-    hasNewGoal_ = true;
+    // an explicit goal tolerance has to be met, otherwise the hand coming to rest is good enough
+    if (!goal->goal_tolerance.empty() && !within)
+    {
+      ROS_WARN("%s: Aborted, hand stopped outside of goal_tolerance", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+      result.error_string = "hand stopped outside of goal_tolerance";
+      as_.setAborted(result);
+      return;
+    }
+
+    // set the action state to succeeded
+    result.error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+    as_.setSucceeded(result);
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    goal_duration_last_ = std::chrono::duration<double>(now - goal_start).count();
+    goal_completion_latency_last_ = std::chrono::duration<double>(now - motion_done).count();
+    ROS_INFO("%s: Succeeded after %f s", action_name_.c_str(), goal_duration_last_.load());
+  }
+
+  /*!
+   * \brief Converts position tolerances of a goal to axis order.
+   *
+   * Follows control_msgs/JointTolerance: 0 selects the default, a negative value disables the check.
+   * \param tolerances tolerances of the goal [rad], joints not listed get the default
+   * \param default_tolerance tolerance in degrees, negative to disable
+   * \param axis_tolerance receives one tolerance per axis in degrees, negative if disabled
+   * \return false if a tolerance names an unknown joint
+   */
+  bool axisTolerances(const std::vector<control_msgs::JointTolerance> &tolerances, double default_tolerance,
+                      std::vector<double> &axis_tolerance) const
+  {
+    axis_tolerance.assign(axes_.size(), default_tolerance);
+    for (size_t i = 0; i < tolerances.size(); i++)
+    {
+      const std::vector<std::string>::const_iterator joint =
+          std::find(joint_names_.begin(), joint_names_.end(), tolerances[i].name);
+      if (joint == joint_names_.end())
+        return false;
+      const double position = tolerances[i].position;
+      if (position != 0.0)
+        axis_tolerance[joint_mapping_.axisOfJoint(joint - joint_names_.begin())] =
+            position > 0.0 ? position * schunk_sdh_ros::kDegPerRad : -1.0;
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Finds the first axis outside of its tolerance.
+   *
+   * \param desired desired positions in axis order [deg]
+   * \param actual actual positions in axis order [deg]
+   * \param tolerance tolerances in axis order [deg], negative ones are not checked
+   * \return the axis or -1 if all checked axes are within their tolerance
+   */
+  static int firstViolation(const double *desired, const double *actual, const std::vector<double> &tolerance)
+  {
+    for (size_t a = 0; a < tolerance.size(); a++)
+    {
+      if (tolerance[a] >= 0.0 && std::fabs(desired[a] - actual[a]) > tolerance[a])
+        return a;
+    }
+    return -1;
+  }
+
+  /// wakes up executeCB when a new goal or a cancel request arrives
+  void preemptCB()
+  {
+    {
+      std::lock_guard<std::mutex> lock(motion_mutex_);
+    }
+    motion_cond_.notify_all();
+  }
+
+  /// wakes up graspCB when a cancel request or a new grasp goal arrives
+  void graspPreemptCB()
+  {
+    {
+      std::lock_guard<std::mutex> lock(grasp_mutex_);
+    }
+    grasp_cond_.notify_all();
+  }
+
+  /// starts tracking the motion to targetAngles_ of a delivered position command
+  void beginMotion(uint64_t seq)
+  {
+    motion_seq_ = seq;
+    motion_started_ = false;
+    motion_delivered_ = std::chrono::steady_clock::now();
+    goal_tolerance_.update();
+    motion_tolerance_ = goal_tolerance_.readBuffer();
+    motion_tolerance_checked_ = false;
+    for (size_t a = 0; a < motion_tolerance_.size(); a++)
+      motion_tolerance_checked_ = motion_tolerance_checked_ || motion_tolerance_[a] >= 0.0;
+  }
+
+  /*!
+   * \brief Checks whether the tracked motion finished and wakes up executeCB.
+   *
+   * The motion is finished as soon as all axes are within the goal tolerance of the target, or when all axes are idle
+   * after one of them moved. If no axis leaves idle (blocked or already there) the motion ends after
+   * motion_start_timeout.
+   */
+  void updateMotion()
+  {
+    if (motion_seq_ == 0)
+      return;
+
+    bool idle = false;
+    if (snapshot_.updated & schunk_sdh_ros::SIGNAL_STATE)
+    {
+      idle = true;
+      for (size_t i = 0; i < snapshot_.state.size(); i++)
+        idle = idle && snapshot_.state[i] == SDH::cSDH::eAS_IDLE;
+      if (!idle)
+        motion_started_ = true;
+    }
+    const bool within = snapshot_.angles.size() == targetAngles_.size()
+        && targetAngles_.size() == motion_tolerance_.size()
+        && firstViolation(targetAngles_.data(), snapshot_.angles.data(), motion_tolerance_) < 0;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const bool timeout = std::chrono::duration<double>(now - motion_delivered_).count() > motion_start_timeout_;
+    if (!(within && motion_tolerance_checked_) && !(idle && (motion_started_ || timeout)))
+      return;
 
-    usleep(500000);  // needed sleep until sdh starts to change status from idle to moving
+    {
+      std::lock_guard<std::mutex> lock(motion_mutex_);
+      motion_done_seq_ = motion_seq_;
+      motion_done_ = now;
+      motion_done_within_ = within;
+    }
+    motion_cond_.notify_all();
+    motion_seq_ = 0;
+  }
 
-    bool finished = false;
-    while (finished == false)
+  /*!
+   * \brief Streams a timed trajectory to the hand at the rate of updateSdh.
+   *
+   * The trajectory is sampled with cubic splines starting at its header stamp (or now). In position mode the sampled
+   * positions are sent as targets, in velocity mode the sampled velocities plus a proportional correction of the
+   * position error. Desired, actual and error are published as action feedback. The goal aborts as soon as an axis
+   * leaves its path tolerance, and succeeds as soon as all axes are within the goal tolerance after the last point.
+   * \param trajectory trajectory of the goal, joint names already mapped to goal_index_of_axis_
+   * \param goal_tolerance tolerance of the final position in axis order [deg], negative if not checked
+   * \param path_tolerance tolerance while moving in axis order [deg], negative if not checked
+   * \param goal_time_tolerance time allowed after the last point to get within the goal tolerance [s]
+   */
+  void streamTrajectory(const trajectory_msgs::JointTrajectory &trajectory, const std::vector<double> &goal_tolerance,
+                        const std::vector<double> &path_tolerance, double goal_time_tolerance)
+  {
+    control_msgs::FollowJointTrajectoryResult result;
+    std::string error;
+    actual_angles_.update();
+    if (!sampler_.init(trajectory, goal_index_of_axis_, actual_angles_.readBuffer().angles, error))
+    {
+      ROS_ERROR("%s: Rejected, %s", action_name_.c_str(), error.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = error;
+      as_.setAborted(result);
+      return;
+    }
+    const std::string mode = operationMode();
+    const bool velocity_mode = (mode == "velocity");
+    ROS_INFO("%s: streaming %d points over %f s in %s mode", action_name_.c_str(),
+             static_cast<int>(trajectory.points.size()), sampler_.duration(), mode.c_str());
+
+    std::vector<double> position(DOF_), velocity(DOF_), setpoint(DOF_);
+    std::vector<double> reference(DOF_), reference_velocity(DOF_);  // desired at the time of the actual angles
+    control_msgs::FollowJointTrajectoryFeedback feedback;
+    feedback.joint_names = joint_names_;
+    feedback.desired.positions.resize(DOF_);
+    feedback.desired.velocities.resize(DOF_);
+    feedback.actual.positions.resize(DOF_);
+    feedback.error.positions.resize(DOF_);
+
+    ros::Time start = trajectory.header.stamp;
+    if (start.isZero())
+      start = ros::Time::now();
+    ros::Rate rate(frequency_);
+    const uint64_t reflex_trips = reflex_trips_;
+    streaming_ = true;
+    bool reached = false;
+    while (ros::ok())
     {
-      if (as_.isNewGoalAvailable())
+      if (as_.isPreemptRequested())
+      {
+        holdPosition(velocity_mode);
+        ROS_WARN("%s: Preempted", action_name_.c_str());
+        as_.setPreempted();
+        return;
+      }
+      if (reflex_trips_ != reflex_trips)
       {
-        ROS_WARN("%s: Aborted", action_name_.c_str());
-        as_.setAborted();
+        holdPosition(velocity_mode);  // replaces a setpoint posted after the reflex stopped the hand
+        result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+        result.error_string = "stopped by the tactile reflex";
+        ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+        as_.setAborted(result);
         return;
       }
-      for (unsigned int i = 0; i < state_.size(); i++)
+
+      // the actual angles were acquired one or two cycles ago, errors compare them with the desired angles of then
+      const double t = (ros::Time::now() - start).toSec();
+      sampler_.sample(t, position.data(), velocity.data());
+      actual_angles_.update();
+      const schunk_sdh_ros::StampedAngles &stamped_actual = actual_angles_.readBuffer();
+      const std::vector<double> &actual = stamped_actual.angles;
+      const double t_actual = (stamped_actual.stamp - start).toSec();
+      sampler_.sample(t_actual, reference.data(), reference_velocity.data());
+      if (velocity_mode)
+      {
+        for (int a = 0; a < DOF_; a++)
+          setpoint[a] = velocity[a] + trajectory_position_gain_ * (reference[a] - actual[a]);
+        command_.post(setpoint);
+      }
+      else
+      {
+        command_.post(position);
+      }
+
+      feedback.header.stamp = stamped_actual.stamp;
+      joint_mapping_.axesToJointsRad(reference.data(), feedback.desired.positions.data());
+      joint_mapping_.axesToJointsRad(reference_velocity.data(), feedback.desired.velocities.data());
+      joint_mapping_.axesToJointsRad(actual.data(), feedback.actual.positions.data());
+      for (int j = 0; j < DOF_; j++)
+        feedback.error.positions[j] = feedback.desired.positions[j] - feedback.actual.positions[j];
+      as_.publishFeedback(feedback);
+
+      if (t < sampler_.duration())
+      {
+        const int axis = firstViolation(reference.data(), actual.data(), path_tolerance);
+        if (axis >= 0)
+        {
+          holdPosition(velocity_mode);
+          result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+          result.error_string = joint_names_[joint_mapping_.jointOfAxis(axis)] + " left its path tolerance";
+          ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+          as_.setAborted(result);
+          return;
+        }
+      }
+      else
+      {
+        const int axis = firstViolation(position.data(), actual.data(), goal_tolerance);
+        if (axis < 0)
+        {
+          reached = true;
+          break;
+        }
+        if (t > sampler_.duration() + goal_time_tolerance)
+        {
+          holdPosition(velocity_mode);
+          result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+          result.error_string = joint_names_[joint_mapping_.jointOfAxis(axis)] + " not within its goal tolerance";
+          ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+          as_.setAborted(result);
+          return;
+        }
+      }
+      // an overrun only delays the next cycle, the trajectory is sampled at the current time anyway
+      rate.sleep();
+    }
+    if (!reached)
+    {
+      holdPosition(velocity_mode);
+      ROS_WARN("%s: Preempted", action_name_.c_str());
+      as_.setPreempted();
+      return;
+    }
+
+    if (velocity_mode)
+    {
+      std::fill(setpoint.begin(), setpoint.end(), 0.0);
+      command_.post(setpoint);
+    }
+    streaming_ = false;
+
+    double max_error = 0.0;
+    for (int j = 0; j < DOF_; j++)
+      max_error = std::max(max_error, std::fabs(feedback.error.positions[j]));
+    ROS_INFO("%s: Succeeded, largest position error at the end %f rad", action_name_.c_str(), max_error);
+    result.error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+    as_.setSucceeded(result);
+  }
+
+  /// ends streaming and keeps the hand where it is
+  void holdPosition(bool velocity_mode)
+  {
+    actual_angles_.update();
+    if (velocity_mode)
+      command_.post(std::vector<double>(DOF_, 0.0));
+    else
+      command_.post(actual_angles_.readBuffer().angles);
+    streaming_ = false;
+  }
+
+  /*!
+   * \brief Executes a CloseUntilContact goal.
+   *
+   * The fingers are driven and stopped by updateSdh, which checks the contacts of the newest tactile frame on every
+   * cycle. This callback only hands over the goal and reports progress, so it is not part of the stop path.
+   */
+  void graspCB(const schunk_sdh_ros::CloseUntilContactGoalConstPtr &goal)
+  {
+    schunk_sdh_ros::CloseUntilContactResult result;
+    result.fingers = finger_names_;
+    result.in_contact.assign(3, false);
+    result.contact_time.assign(3, 0.0);
+    const std::string name = ros::this_node::getName() + "/close_until_contact";
+    if (!isInitialized_ || operationMode() != "velocity")
+    {
+      ROS_ERROR("%s: Rejected, sdh not initialized or not in velocity mode", name.c_str());
+      grasp_as_.setAborted(result, "sdh not initialized or not in velocity mode");
+      return;
+    }
+    if (!isDSAInitialized_)
+    {
+      ROS_ERROR("%s: Rejected, tactile sensors not connected", name.c_str());
+      grasp_as_.setAborted(result, "tactile sensors not connected");
+      return;
+    }
+
+    // older commands must not take the hand over from the grasp
+    command_.discard();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t seq;
+    {
+      std::lock_guard<std::mutex> lock(grasp_mutex_);
+      seq = ++grasp_seq_;
+      grasp_velocity_ = goal->velocity * schunk_sdh_ros::kDegPerRad;
+      grasp_stopped_ = 0;
+    }
+    finger_contact_ = 0;  // may be left over from an earlier grasp, the next frame sets it
+    grasp_sense_ = true;
+    grasp_requested_ = true;
+    ROS_INFO("%s: closing at %f rad/s", name.c_str(), goal->velocity);
+
+    schunk_sdh_ros::CloseUntilContactFeedback feedback;
+    feedback.fingers = finger_names_;
+    feedback.in_contact.assign(3, false);
+    uint32_t reported = 0;
+    // preempts and contacts notify grasp_cond_, the period only bounds the reaction to a disconnect or shutdown
+    const std::chrono::steady_clock::duration period = std::chrono::milliseconds(100);
+    const bool has_timeout = goal->timeout > 0.0;
+    const std::chrono::steady_clock::time_point deadline =
+        start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(has_timeout ? goal->timeout : 0.0));
+    std::unique_lock<std::mutex> lock(grasp_mutex_);
+    while (grasp_ended_seq_ < seq)
+    {
+      const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      const bool timeout = has_timeout && now >= deadline;
+      if (grasp_as_.isPreemptRequested() || timeout || !isInitialized_ || !ros::ok())
       {
-        ROS_DEBUG("state[%d] = %d", i, state_[i]);
-        if (state_[i] == 0)
+        lock.unlock();
+        // a zero velocity command ends the grasp in updateSdh and stops the fingers that still move
+        command_.post(std::vector<double>(DOF_, 0.0));
+        grasp_sense_ = false;
+        if (timeout)
         {
-          finished = true;
+          ROS_WARN("%s: Aborted, not all fingers touched within %f s", name.c_str(), goal->timeout);
+          grasp_as_.setAborted(result, "not all fingers touched within the timeout");
         }
         else
         {
-          finished = false;
+          ROS_WARN("%s: Preempted", name.c_str());
+          grasp_as_.setPreempted(result);
         }
+        return;
       }
-      usleep(10000);
-      // feedback_ =
-      // as_.send feedback_
+      if (grasp_stopped_ != reported)
+      {
+        reported = grasp_stopped_;
+        for (int f = 0; f < 3; f++)
+          feedback.in_contact[f] = (reported >> f) & 1u;
+        grasp_as_.publishFeedback(feedback);
+      }
+      std::chrono::steady_clock::time_point wakeup = now + period;
+      if (has_timeout && deadline < wakeup)
+        wakeup = deadline;
+      grasp_cond_.wait_until(lock, wakeup);
+    }
+    const uint32_t stopped = grasp_stopped_;
+    for (int f = 0; f < 3; f++)
+    {
+      result.in_contact[f] = (stopped >> f) & 1u;
+      if (result.in_contact[f])
+        result.contact_time[f] = std::chrono::duration<double>(grasp_stop_time_[f] - start).count();
     }
+    lock.unlock();
+    grasp_sense_ = false;
 
-    // set the action state to succeeded
-    ROS_INFO("%s: Succeeded", action_name_.c_str());
-    // result_.result.data = "succesfully received new goal";
-    // result_.success = 1;
-    // as_.setSucceeded(result_);
-    as_.setSucceeded();
+    if (stopped != 7u)
+    {
+      ROS_WARN("%s: Aborted, interrupted by another command or the tactile reflex", name.c_str());
+      grasp_as_.setAborted(result, "interrupted by another command or the tactile reflex");
+      return;
+    }
+    ROS_INFO("%s: Succeeded, all fingers in contact", name.c_str());
+    grasp_as_.setSucceeded(result);
+  }
+
+  /*!
+   * \brief Runs the grasp on every cycle, called by updateSdh with the SDH lock held.
+   *
+   * Proximal and distal axis of each finger move at the grasp velocity until a matrix of the finger reports contact in
+   * the newest tactile frame, then both get velocity zero. The knuckle does not move. New velocities are only sent
+   * when a finger stopped.
+   */
+  void updateGrasp()
+  {
+    bool start = false;
+    double velocity = 0.0;
+    if (grasp_requested_)
+    {
+      grasp_requested_ = false;
+      std::lock_guard<std::mutex> lock(grasp_mutex_);
+      if (grasp_running_)
+        grasp_ended_seq_ = grasp_running_;  // replaced by the new goal
+      grasp_running_ = grasp_seq_;
+      grasp_running_stopped_ = 0;
+      velocity = grasp_velocity_;
+      start = true;
+    }
+    if (!grasp_running_)
+      return;
+
+    const uint32_t stopped = grasp_running_stopped_ | (finger_contact_ & 7u);
+    if (!start && stopped == grasp_running_stopped_)
+      return;
+
+    if (start)
+    {
+      std::fill(velocities_.begin(), velocities_.end(), 0.0);
+      for (int f = 0; f < 3; f++)
+      {
+        velocities_[1 + 2 * f] = velocity;  // proximal
+        velocities_[2 + 2 * f] = velocity;  // distal
+      }
+    }
+    for (int f = 0; f < 3; f++)
+    {
+      if ((stopped >> f) & 1u)
+        velocities_[1 + 2 * f] = velocities_[2 + 2 * f] = 0.0;
+    }
+    try
+    {
+      schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_VELOCITY);
+      sdh_->SetAxisTargetVelocity(axes_, velocities_);
+    }
+    catch (SDH::cSDHLibraryException* e)
+    {
+      ROS_ERROR("An exception was caught: %s", e->what());
+      delete e;
+    }
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(grasp_mutex_);
+      for (int f = 0; f < 3; f++)
+      {
+        if (((stopped & ~grasp_running_stopped_) >> f) & 1u)
+          grasp_stop_time_[f] = now;
+      }
+      grasp_stopped_ = stopped;
+      if (stopped == 7u)
+        grasp_ended_seq_ = grasp_running_;
+    }
+    grasp_running_stopped_ = stopped;
+    if (stopped == 7u)
+      grasp_running_ = 0;
+    grasp_cond_.notify_all();
+  }
+
+  /// ends the running grasp before the hand follows another command, the fingers keep their velocities until then
+  void endGrasp()
+  {
+    {
+      std::lock_guard<std::mutex> lock(grasp_mutex_);
+      grasp_ended_seq_ = grasp_running_;
+    }
+    grasp_running_ = 0;
+    grasp_cond_.notify_all();
   }
 
   void topicCallback_setVelocitiesRaw(const std_msgs::Float64MultiArrayPtr& velocities)
@@ -384,25 +1115,16 @@ public:
       ROS_ERROR("Velocity array dimension mismatch");
       return;
     }
-    if (operationMode_ != "velocity")
+    if (operationMode() != "velocity")
     {
       ROS_ERROR("%s: Rejected, sdh not in velocity mode", action_name_.c_str());
       return;
     }
 
-    // TODO: write proper lock!
-    while (hasNewGoal_ == true)
-      usleep(10000);
-
-    velocities_[0] = velocities->data[0] * 180.0 / pi_;  // sdh_knuckle_joint
-    velocities_[1] = velocities->data[5] * 180.0 / pi_;  // sdh_finger22_joint
-    velocities_[2] = velocities->data[6] * 180.0 / pi_;  // sdh_finger23_joint
-    velocities_[3] = velocities->data[1] * 180.0 / pi_;  // sdh_thumb2_joint
-    velocities_[4] = velocities->data[2] * 180.0 / pi_;  // sdh_thumb3_joint
-    velocities_[5] = velocities->data[3] * 180.0 / pi_;  // sdh_finger12_joint
-    velocities_[6] = velocities->data[4] * 180.0 / pi_;  // sdh_finger13_joint
+    std::vector<double> targetVelocities(DOF_);
+    joint_mapping_.jointsToAxesDeg(velocities->data.data(), targetVelocities.data());
 
-    hasNewGoal_ = true;
+    command_.post(targetVelocities);
   }
 
   /*!
@@ -414,6 +1136,7 @@ public:
    */
   bool srvCallback_Init(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
   {
+    std::lock_guard<std::mutex> sdh_lock(sdh_mutex_);
     if (isInitialized_ == false)
     {
       // Init Hand connection
@@ -475,9 +1198,11 @@ public:
       // Init tactile data
       if (!dsadevicestring_.empty())
       {
+        std::lock_guard<std::mutex> dsa_lock(dsa_mutex_);
         try
         {
           dsa_ = new SDH::cDSA(dsa_dbg_level_, dsadevicenum_, dsadevicestring_.c_str());
+          dsa_clock_.reset();
           // dsa_->SetFramerate( 0, true, false );
           dsa_->SetFramerate(1, true);
           ROS_INFO("Initialized RS232 for DSA Tactile Sensors on device %s", dsadevicestring_.c_str());
@@ -527,6 +1252,7 @@ public:
     ROS_INFO("Stopping sdh");
 
     // stopping all arm movements
+    std::lock_guard<std::mutex> lock(sdh_mutex_);
     try
     {
       sdh_->Stop();
@@ -552,10 +1278,11 @@ public:
    */
   bool srvCallback_SetOperationMode(cob_srvs::SetString::Request &req, cob_srvs::SetString::Response &res)
   {
-    hasNewGoal_ = false;
+    std::lock_guard<std::mutex> lock(sdh_mutex_);
+    command_.discard();
     sdh_->Stop();
     ROS_INFO("Set operation mode to [%s]", req.data.c_str());
-    operationMode_ = req.data;
+    setOperationMode(req.data);
     res.success = true;
     res.message = "Set operation mode to "+req.data;
     if (operationMode_ == "position")
@@ -590,6 +1317,7 @@ public:
    * \param res Service response
    */
   bool srvCallback_EmergencyStop(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res) {
+      std::lock_guard<std::mutex> lock(sdh_mutex_);
       try {
         isInitialized_ = false;
         sdh_->EmergencyStop();
@@ -616,6 +1344,8 @@ public:
    * \param res Service response
    */
   bool srvCallback_Disconnect(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res) {
+      std::lock_guard<std::mutex> sdh_lock(sdh_mutex_);
+      std::lock_guard<std::mutex> dsa_lock(dsa_mutex_);
       try {
         isInitialized_ = false;
         isDSAInitialized_ = false;
@@ -645,6 +1375,7 @@ public:
    * \param res Service response
    */
   bool srvCallback_MotorPowerOn(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res) {
+    std::lock_guard<std::mutex> lock(sdh_mutex_);
     try {
       sdh_->SetAxisEnable(sdh_->All, 1.0);
       sdh_->SetAxisMotorCurrent(sdh_->All, 0.5);
@@ -667,6 +1398,7 @@ public:
    * \param res Service response
    */
   bool srvCallback_MotorPowerOff(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res) {
+    std::lock_guard<std::mutex> lock(sdh_mutex_);
     try {
       sdh_->SetAxisEnable(sdh_->All, 0.0);
       sdh_->SetAxisMotorCurrent(sdh_->All, 0.0);
@@ -683,6 +1415,70 @@ public:
     return true;
   }
 
+  /*!
+   * \brief Publishes joint states, controller state and temperatures of an acquired snapshot.
+   *
+   * \param snapshot feedback read from the hand
+   */
+  void publishSnapshot(const schunk_sdh_ros::AxisSnapshot &snapshot)
+  {
+    if (snapshot.updated & schunk_sdh_ros::SIGNAL_TEMPERATURES)
+      publishTemperatures(snapshot);
+
+    // joint states follow the angle rate, velocities are taken from the last read
+    if (!(snapshot.updated & schunk_sdh_ros::SIGNAL_ANGLES) || snapshot.velocities.size() != axes_.size())
+      return;
+
+    ROS_DEBUG("received %d angles from sdh", static_cast<int>(snapshot.angles.size()));
+
+    feedbackMsgs_.fillJointStates(snapshot, targetAngles_);
+    topicPub_JointState_.publish(feedbackMsgs_.jointState());
+    topicPub_JointState_.publish(feedbackMsgs_.mimicJoint());
+    topicPub_ControllerState_.publish(feedbackMsgs_.controllerState());
+  }
+
+  /*!
+   * \brief Publishes the temperatures of an acquired snapshot.
+   *
+   * \param snapshot feedback read from the hand
+   */
+  void publishTemperatures(const schunk_sdh_ros::AxisSnapshot &snapshot)
+  {
+    if (!feedbackMsgs_.fillTemperatures(snapshot))
+    {
+      ROS_ERROR("amount of temperatures mismatch with stored names");
+      return;
+    }
+    topicPub_Temperature_.publish(feedbackMsgs_.temperatures());
+  }
+
+  /*!
+   * \brief Sets up the rates of the feedback signals.
+   *
+   * Rates are read from the parameters signal_rates/{angles,velocities,state,temperature,diagnostics} and capped at the
+   * loop frequency. Slow signals are spread over different cycles.
+   * \param frequency rate at which updateSdh() is called [Hz]
+   */
+  void setupScheduler(double frequency)
+  {
+    frequency_ = frequency;
+    double angles, velocities, state, temperature, diagnostics;
+    nh_.param("signal_rates/angles", angles, frequency);
+    nh_.param("signal_rates/velocities", velocities, frequency);
+    nh_.param("signal_rates/state", state, frequency);
+    nh_.param("signal_rates/temperature", temperature, 1.0);
+    nh_.param("signal_rates/diagnostics", diagnostics, 1.0);
+
+    scheduler_.reset(frequency);
+    sig_angles_ = scheduler_.add("angles", angles);
+    sig_velocities_ = scheduler_.add("velocities", velocities);
+    sig_state_ = scheduler_.add("state", state);
+    sig_temperature_ = scheduler_.add("temperature", temperature);
+    sig_diagnostics_ = scheduler_.add("diagnostics", diagnostics);
+    for (int id = sig_angles_; id <= sig_diagnostics_; id++)
+      ROS_INFO("%s published at %f Hz", scheduler_.name(id).c_str(), scheduler_.rate(id));
+  }
+
   /*!
    * \brief Main routine to update sdh.
    *
@@ -690,44 +1486,83 @@ public:
    */
   void updateSdh()
   {
-    const ros::Time time = ros::Time::now();
     ROS_DEBUG("updateJointState");
+    // signals to serve in this cycle
+    unsigned int signals = 0;
+    if (scheduler_.due(sig_angles_))
+      signals |= schunk_sdh_ros::SIGNAL_ANGLES;
+    if (scheduler_.due(sig_velocities_))
+      signals |= schunk_sdh_ros::SIGNAL_VELOCITIES;
+    if (scheduler_.due(sig_state_))
+      signals |= schunk_sdh_ros::SIGNAL_STATE;
+    if (scheduler_.due(sig_temperature_))
+      signals |= schunk_sdh_ros::SIGNAL_TEMPERATURES;
+    const bool publish_diagnostics = scheduler_.due(sig_diagnostics_);
+    scheduler_.tick();
+
+    bool has_snapshot = false;
+    std::unique_lock<std::mutex> lock(sdh_mutex_);
     if (isInitialized_ == true)
     {
-      if (hasNewGoal_ == true)
+      if (reflex_trips_ != reflex_executed_)
+        executeReflex();
+      updateGrasp();
+
+      const schunk_sdh_ros::CommandMailbox<std::vector<double> >::Command *command = command_.fetch();
+      if (command)
       {
-        // stop sdh first when new goal arrived
-        try
-        {
-          sdh_->Stop();
-        }
-        catch (SDH::cSDHLibraryException* e)
+        if (grasp_running_)
+          endGrasp();  // the hand follows the new command
+
+        // stop sdh first when new goal arrived, streamed setpoints continue the running motion
+        if (!streaming_)
         {
-          ROS_ERROR("An exception was caught: %s", e->what());
-          delete e;
+          try
+          {
+            schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_STOP);
+            sdh_->Stop();
+          }
+          catch (SDH::cSDHLibraryException* e)
+          {
+            ROS_ERROR("An exception was caught: %s", e->what());
+            delete e;
+          }
         }
 
         if (operationMode_ == "position")
         {
           ROS_DEBUG("moving sdh in position mode");
 
+          targetAngles_ = command->value;
           try
           {
-            sdh_->SetAxisTargetAngle(axes_, targetAngles_);
-            sdh_->MoveHand(false);
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_ANGLE);
+              sdh_->SetAxisTargetAngle(axes_, targetAngles_);
+            }
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_MOVE_HAND);
+              sdh_->MoveHand(false);
+            }
           }
           catch (SDH::cSDHLibraryException* e)
           {
             ROS_ERROR("An exception was caught: %s", e->what());
             delete e;
           }
+          if (!streaming_)
+            beginMotion(command->seq);
         }
         else if (operationMode_ == "velocity")
         {
           ROS_DEBUG("moving sdh in velocity mode");
+          velocities_ = command->value;
           try
           {
-            sdh_->SetAxisTargetVelocity(axes_, velocities_);
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_VELOCITY);
+              sdh_->SetAxisTargetVelocity(axes_, velocities_);
+            }
             // ROS_DEBUG_STREAM("velocities: " << velocities_[0] << " "<< velocities_[1] << " "<< velocities_[2] << " "<< velocities_[3] << " "<< velocities_[4] << " "<< velocities_[5] << " "<< velocities_[6]);
           }
           catch (SDH::cSDHLibraryException* e)
@@ -748,132 +1583,42 @@ public:
                     operationMode_.c_str());
         }
 
-        hasNewGoal_ = false;
-      }
-
-      // read and publish joint angles and velocities
-      std::vector<double> actualAngles;
-      try
-      {
-        actualAngles = sdh_->GetAxisActualAngle(axes_);
-      }
-      catch (SDH::cSDHLibraryException* e)
-      {
-        ROS_ERROR("An exception was caught: %s", e->what());
-        delete e;
-      }
-      std::vector<double> actualVelocities;
-      try
-      {
-        actualVelocities = sdh_->GetAxisActualVelocity(axes_);
-      }
-      catch (SDH::cSDHLibraryException* e)
-      {
-        ROS_ERROR("An exception was caught: %s", e->what());
-        delete e;
+        command_.delivered(*command);
       }
 
-      ROS_DEBUG("received %d angles from sdh", static_cast<int>(actualAngles.size()));
-
-      // create joint_state message
-      sensor_msgs::JointState msg;
-      msg.header.stamp = time;
-      msg.name.resize(DOF_);
-      msg.position.resize(DOF_);
-      msg.velocity.resize(DOF_);
-      msg.effort.resize(DOF_);
-      // set joint names and map them to angles
-      msg.name = joint_names_;
-      // ['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']
-      // pos
-      msg.position[0] = actualAngles[0] * pi_ / 180.0;  // sdh_knuckle_joint
-      msg.position[1] = actualAngles[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-      msg.position[2] = actualAngles[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-      msg.position[3] = actualAngles[5] * pi_ / 180.0;  // sdh_finger_12_joint
-      msg.position[4] = actualAngles[6] * pi_ / 180.0;  // sdh_finger_13_joint
-      msg.position[5] = actualAngles[1] * pi_ / 180.0;  // sdh_finger_22_joint
-      msg.position[6] = actualAngles[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      // vel
-      msg.velocity[0] = actualVelocities[0] * pi_ / 180.0;  // sdh_knuckle_joint
-      msg.velocity[1] = actualVelocities[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-      msg.velocity[2] = actualVelocities[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-      msg.velocity[3] = actualVelocities[5] * pi_ / 180.0;  // sdh_finger_12_joint
-      msg.velocity[4] = actualVelocities[6] * pi_ / 180.0;  // sdh_finger_13_joint
-      msg.velocity[5] = actualVelocities[1] * pi_ / 180.0;  // sdh_finger_22_joint
-      msg.velocity[6] = actualVelocities[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      // publish message
-      topicPub_JointState_.publish(msg);
-
-      // because the robot_state_publisher doen't know about the mimic joint, we have to publish the coupled joint separately
-      sensor_msgs::JointState mimicjointmsg;
-      mimicjointmsg.header.stamp = time;
-      mimicjointmsg.name.resize(1);
-      mimicjointmsg.position.resize(1);
-      mimicjointmsg.velocity.resize(1);
-      mimicjointmsg.name[0] = "sdh_finger_21_joint";
-      mimicjointmsg.position[0] = msg.position[0];  // sdh_knuckle_joint = sdh_finger_21_joint
-      mimicjointmsg.velocity[0] = msg.velocity[0];  // sdh_knuckle_joint = sdh_finger_21_joint
-      topicPub_JointState_.publish(mimicjointmsg);
-
-      // publish controller state message
-      control_msgs::JointTrajectoryControllerState controllermsg;
-      controllermsg.header.stamp = time;
-      controllermsg.joint_names.resize(DOF_);
-      controllermsg.desired.positions.resize(DOF_);
-      controllermsg.desired.velocities.resize(DOF_);
-      controllermsg.actual.positions.resize(DOF_);
-      controllermsg.actual.velocities.resize(DOF_);
-      controllermsg.error.positions.resize(DOF_);
-      controllermsg.error.velocities.resize(DOF_);
-      // set joint names and map them to angles
-      controllermsg.joint_names = joint_names_;
-      // ['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']
-      // desired pos
-      if (targetAngles_.size() != 0)
-      {
-        controllermsg.desired.positions[0] = targetAngles_[0] * pi_ / 180.0;  // sdh_knuckle_joint
-        controllermsg.desired.positions[1] = targetAngles_[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-        controllermsg.desired.positions[2] = targetAngles_[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-        controllermsg.desired.positions[3] = targetAngles_[5] * pi_ / 180.0;  // sdh_finger_12_joint
-        controllermsg.desired.positions[4] = targetAngles_[6] * pi_ / 180.0;  // sdh_finger_13_joint
-        controllermsg.desired.positions[5] = targetAngles_[1] * pi_ / 180.0;  // sdh_finger_22_joint
-        controllermsg.desired.positions[6] = targetAngles_[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      }
-      // desired vel
-      // they are all zero
-      // actual pos
-      controllermsg.actual.positions = msg.position;
-      // actual vel
-      controllermsg.actual.velocities = msg.velocity;
-      // error, calculated out of desired and actual values
-      for (int i = 0; i < DOF_; i++)
+      // read the due signals in one acquisition
+      if (signals != 0
+          && schunk_sdh_ros::readAxisSnapshot(*sdh_, axes_, sdh_->all_temperature_sensors, signals, snapshot_,
+                                             &profiler_))
       {
-        controllermsg.error.positions[i] = controllermsg.desired.positions[i] - controllermsg.actual.positions[i];
-        controllermsg.error.velocities[i] = controllermsg.desired.velocities[i] - controllermsg.actual.velocities[i];
-      }
-      // publish controller message
-      topicPub_ControllerState_.publish(controllermsg);
-
-      // read sdh status
-      state_ = sdh_->GetAxisActualState(axes_);
-
-      // publish temperature
-      schunk_sdh::TemperatureArray temp_array;
-      temp_array.header.stamp = time;
-      const std::vector<double> temp_value = sdh_->GetTemperature(sdh_->all_temperature_sensors);
-      if(temp_value.size()==temperature_names_.size()) {
-          temp_array.name = temperature_names_;
-          temp_array.temperature = temp_value;
-      }
-      else {
-          ROS_ERROR("amount of temperatures mismatch with stored names");
+        if (snapshot_.updated & schunk_sdh_ros::SIGNAL_ANGLES)
+        {
+          schunk_sdh_ros::StampedAngles &angles = actual_angles_.writeBuffer();
+          angles.stamp = snapshot_.stamp;
+          angles.angles = snapshot_.angles;
+          actual_angles_.publish();
+        }
+        updateMotion();
+        has_snapshot = true;
       }
-      topicPub_Temperature_.publish(temp_array);
     }
     else
     {
       ROS_DEBUG("sdh not initialized");
     }
+    lock.unlock();
+
+    if (has_snapshot)
+      publishSnapshot(snapshot_);
+
+    if (!publish_diagnostics)
+      return;
+
+    // latencies of the hardware calls since the last report
+    diagnostic_msgs::DiagnosticArray call_stats;
+    profiler_.summarize(nh_.getNamespace() + "/", call_stats);
+    topicPub_CallStats_.publish(call_stats);
+
     // publishing diagnotic messages
     diagnostic_msgs::DiagnosticArray diagnostics;
     diagnostics.status.resize(1);
@@ -894,6 +1639,47 @@ public:
           diagnostics.status[0].message = "sdh with tactile sensing initialized and running";
         else
           diagnostics.status[0].message = "sdh initialized and running, tactile sensors not connected";
+        diagnostic_msgs::KeyValue kv;
+        kv.key = "command_latency_last";
+        kv.value = boost::lexical_cast<std::string>(command_.latencyLast());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "command_latency_max";
+        kv.value = boost::lexical_cast<std::string>(command_.latencyMax());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "feedback_io_time";
+        kv.value = boost::lexical_cast<std::string>(snapshot_.io_time);
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "goal_duration_last";
+        kv.value = boost::lexical_cast<std::string>(goal_duration_last_.load());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "goal_completion_latency_last";
+        kv.value = boost::lexical_cast<std::string>(goal_completion_latency_last_.load());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "message_allocations";
+        kv.value = boost::lexical_cast<std::string>(feedbackMsgs_.allocations());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "dsa_frames_read";
+        kv.value = boost::lexical_cast<std::string>(dsa_frames_read_.load());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "dsa_read_errors";
+        kv.value = boost::lexical_cast<std::string>(dsa_read_errors_.load());
+        diagnostics.status[0].values.push_back(kv);
+        if (reflex_enabled_)
+        {
+          kv.key = "reflex_trips";
+          kv.value = boost::lexical_cast<std::string>(reflex_trips_.load());
+          diagnostics.status[0].values.push_back(kv);
+          kv.key = "reflex_latency_last";
+          kv.value = boost::lexical_cast<std::string>(reflex_latency_last_);
+          diagnostics.status[0].values.push_back(kv);
+          kv.key = "reflex_latency_max";
+          kv.value = boost::lexical_cast<std::string>(reflex_latency_max_);
+          diagnostics.status[0].values.push_back(kv);
+          kv.key = "reflex_acquisition_latency_last";
+          kv.value = boost::lexical_cast<std::string>(reflex_acquisition_latency_last_);
+          diagnostics.status[0].values.push_back(kv);
+          reflex_latency_max_ = 0.0;
+        }
       }
       else
       {
@@ -902,10 +1688,112 @@ public:
         diagnostics.status[0].message = "sdh not initialized";
       }
     }
+    if (threaded_)
+    {
+      addCycleStats("sdh_loop", sdh_stats_.latest(), diagnostics.status[0]);
+      addCycleStats("dsa_loop", dsa_stats_.latest(), diagnostics.status[0]);
+    }
     // publish diagnostic message
     topicPub_Diagnostics_.publish(diagnostics);
   }
 
+  /*!
+   * \brief Stops the hand after the tactile reflex tripped, called by updateSdh with the SDH lock held.
+   *
+   * In velocity mode all axes get velocity zero, which keeps the controller in velocity mode, otherwise the hand is
+   * stopped. Commands posted before are dropped and a running goal is aborted, commands posted afterwards are executed
+   * as usual.
+   *
+   * Latency: the reader thread checks every frame as soon as it arrived, the stop goes out at the start of the next
+   * updateSdh cycle. Detection to command therefore takes at most one cycle of updateSdh plus the duration of the call
+   * itself, reported as reflex_latency_last and reflex_latency_max. Acquisition to command, which adds the transfer of
+   * the frame, is reported as reflex_acquisition_latency_last.
+   */
+  void executeReflex()
+  {
+    reflex_executed_ = reflex_trips_;
+    ros::Time frame_stamp;
+    std::chrono::steady_clock::time_point detected;
+    int matrix;
+    {
+      std::lock_guard<std::mutex> lock(reflex_mutex_);
+      frame_stamp = reflex_frame_stamp_;
+      detected = reflex_detected_;
+      matrix = reflex_matrix_;
+    }
+
+    command_.discard();
+    if (grasp_running_)
+      endGrasp();
+    try
+    {
+      if (operationMode_ == "velocity")
+      {
+        std::fill(velocities_.begin(), velocities_.end(), 0.0);
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_VELOCITY);
+        sdh_->SetAxisTargetVelocity(axes_, velocities_);
+      }
+      else
+      {
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_STOP);
+        sdh_->Stop();
+      }
+    }
+    catch (SDH::cSDHLibraryException* e)
+    {
+      ROS_ERROR("An exception was caught: %s", e->what());
+      delete e;
+    }
+    reflex_latency_last_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - detected).count();
+    reflex_latency_max_ = std::max(reflex_latency_max_, reflex_latency_last_);
+    reflex_acquisition_latency_last_ = (ros::Time::now() - frame_stamp).toSec();
+    ROS_WARN("tactile reflex: matrix %d exceeded its force threshold, hand stopped after %f s", matrix,
+             reflex_latency_last_);
+
+    // the tracked motion ends here, executeCB sees the trip and aborts
+    if (motion_seq_ != 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock(motion_mutex_);
+        motion_done_seq_ = motion_seq_;
+        motion_done_ = std::chrono::steady_clock::now();
+        motion_done_within_ = false;
+      }
+      motion_cond_.notify_all();
+      motion_seq_ = 0;
+    }
+  }
+
+  /// decodes the contacts of a new frame for the grasp and checks the reflex thresholds, called by the reader thread
+  void checkContacts(const schunk_sdh_ros::DsaFrame &frame)
+  {
+    contact_decoder_.decode(frame, 0, 0, &contacts_);
+    uint32_t fingers = 0;
+    for (int finger = 0; finger < 3 && frame.matrix_index.size() == 6; finger++)
+    {
+      for (int part = 0; part < 2; part++)
+      {
+        const int m = frame.matrix_index[2 * finger + part];
+        if (m >= 0 && m < static_cast<int>(contacts_.size()) && contacts_[m].force > 0)
+          fingers |= 1u << finger;
+      }
+    }
+    finger_contact_ = fingers;
+
+    if (!reflex_enabled_)
+      return;
+    const int matrix = reflex_.check(contacts_, contact_decoder_);
+    if (matrix < 0)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(reflex_mutex_);
+      reflex_frame_stamp_ = frame.stamp;
+      reflex_detected_ = std::chrono::steady_clock::now();
+      reflex_matrix_ = matrix;
+    }
+    ++reflex_trips_;
+  }
+
   /*!
    * \brief Main routine to update dsa.
    *
@@ -913,77 +1801,159 @@ public:
    */
   void updateDsa()
   {
-    static const int dsa_reorder[6] = {2, 3, 4, 5, 0, 1};  // t1,t2,f11,f12,f21,f22
     ROS_DEBUG("updateTactileData");
 
-    if (isDSAInitialized_)
+    // newest complete frame of the reader thread, each sensor frame is decoded and published once
+    dsa_frames_.update();
+    const schunk_sdh_ros::DsaFrame &frame = dsa_frames_.readBuffer();
+    if (!tactile_decoder_.isNew(frame))
+      return;
+
+    // unused topics are not decoded at all
+    const bool tactile = topicPub_TactileSensor_.getNumSubscribers() > 0;
+    const bool pressure = topicPub_Pressure_.getNumSubscribers() > 0;
+    if (!tactile && !pressure)
+      return;
+    tactile_decoder_.decode(frame, tactile ? tactileMsg_.acquire().get() : 0,
+                            pressure ? pressureMsg_.acquire().get() : 0, 0);
+    // publish matrix
+    if (tactile)
+      topicPub_TactileSensor_.publish(tactileMsg_.current());
+    if (pressure)
+      topicPub_Pressure_.publish(pressureMsg_.current());
+  }
+
+  /// linear calibration from dsa_calib_pressure and dsa_calib_voltage [Pa per raw unit]
+  double defaultPressureGain() const
+  {
+    return dsa_calib_pressure_ / dsa_calib_voltage_ * 1e6;
+  }
+
+  /*!
+   * \brief Starts the thread that reads tactile frames.
+   *
+   * It keeps the DSA stream drained while the sensor is connected, so neither the joint loop nor updateDsa() ever wait
+   * for the serial line. Called once in both the threaded and the single-threaded mode.
+   */
+  void startDsaReader()
+  {
+    dsa_reader_running_ = true;
+    dsa_reader_thread_ = std::thread(&SdhNode::readDsaLoop, this);
+  }
+
+  /*!
+   * \brief Starts the threaded mode.
+   *
+   * updateSdh() and updateDsa() are executed on two separate fixed-rate threads, so publishing tactile data can no
+   * longer stretch the joint state cycle. ROS callbacks have to be served by an AsyncSpinner.
+   * \param sdh_frequency rate of the SDH loop
+   * \param dsa_frequency rate of the DSA loop
+   */
+  void startThreads(double sdh_frequency, double dsa_frequency)
+  {
+    threaded_ = true;
+    running_ = true;
+    sdh_thread_ = std::thread(&SdhNode::runLoop, this, sdh_frequency, &SdhNode::updateSdh, &sdh_stats_);
+    dsa_thread_ = std::thread(&SdhNode::runLoop, this, dsa_frequency, &SdhNode::updateDsa, &dsa_stats_);
+  }
+
+  /*!
+   * \brief Stops the threads started by startThreads() and startDsaReader() and waits for them.
+   */
+  void stopThreads()
+  {
+    running_ = false;
+    dsa_reader_running_ = false;
+    if (sdh_thread_.joinable())
+      sdh_thread_.join();
+    if (dsa_thread_.joinable())
+      dsa_thread_.join();
+    if (dsa_reader_thread_.joinable())
+      dsa_reader_thread_.join();
+  }
+
+private:
+  /*!
+   * \brief Body of the reader thread.
+   *
+   * UpdateFrame() blocks until the next frame of the stream arrives, so the loop runs at the sensor frame rate. The
+   * DSA lock is only held for one frame, Init and Disconnect get their turn in between.
+   */
+  void readDsaLoop()
+  {
+    while (dsa_reader_running_ && ros::ok())
     {
-      // read tactile data
-      for (int i = 0; i < 7; i++)
+      bool connected = false;
       {
-        try
-        {
-          // dsa_->SetFramerate( 0, true, true );
-          dsa_->UpdateFrame();
-        }
-        catch (SDH::cSDHLibraryException* e)
+        std::lock_guard<std::mutex> lock(dsa_mutex_);
+        if (isDSAInitialized_)
         {
-          ROS_ERROR("An exception was caught: %s", e->what());
-          delete e;
+          connected = true;
+          try
+          {
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_DSA_UPDATE_FRAME);
+              dsa_->UpdateFrame();
+            }
+            const ros::Time stamp = dsa_clock_.update(dsa_->GetFrame().timestamp, ros::Time::now());
+            schunk_sdh_ros::copyDsaFrame(*dsa_, stamp, ++dsa_frames_read_, dsa_frames_.writeBuffer());
+            if (reflex_enabled_ || grasp_sense_)
+              checkContacts(dsa_frames_.writeBuffer());
+            dsa_frames_.publish();
+          }
+          catch (SDH::cSDHLibraryException* e)
+          {
+            ROS_ERROR("An exception was caught: %s", e->what());
+            delete e;
+            ++dsa_read_errors_;
+            connected = false;  // back off instead of spinning on a broken stream
+          }
         }
       }
+      if (connected)
+        std::this_thread::yield();
+      else
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
 
-      schunk_sdh::TactileSensor msg;
-      msg.header.stamp = ros::Time::now();
-      msg.tactile_matrix.resize(dsa_->GetSensorInfo().nb_matrices);
-      for (int i = 0; i < dsa_->GetSensorInfo().nb_matrices; i++)
-      {
-        const int m = dsa_reorder[i];
-        schunk_sdh::TactileMatrix &tm = msg.tactile_matrix[i];
-        tm.matrix_id = i;
-        tm.cells_x = dsa_->GetMatrixInfo(m).cells_x;
-        tm.cells_y = dsa_->GetMatrixInfo(m).cells_y;
-        tm.tactile_array.resize(tm.cells_x * tm.cells_y);
-        for (uint y = 0; y < tm.cells_y; y++)
-        {
-          for (uint x = 0; x < tm.cells_x; x++)
-            tm.tactile_array[tm.cells_x * y + x] = dsa_->GetTexel(m, x, y);
-        }
-      }
-      // publish matrix
-      topicPub_TactileSensor_.publish(msg);
-
-      // read tactile matrices and convert to pressure units
-      schunk_sdh::PressureArrayList msg_pressure_list;
-      msg_pressure_list.header.stamp = ros::Time::now();
-      const SDH::cDSA::sSensorInfo &sensor_info = dsa_->GetSensorInfo();
-      msg_pressure_list.pressure_list.resize(sensor_info.nb_matrices);
-      for(const uint &fi : {0,1,2}) {
-        for(const uint &part : {0,1}) {
-          // get internal ID and name for each finger tactile matrix
-          const int mid = dsa_->GetMatrixIndex(fi, part);
-          msg_pressure_list.pressure_list[mid].sensor_name = "sdh_"+finger_names_[fi]+std::to_string(part+2)+"_link";
-
-          // read texel values and convert to pressure
-          const SDH::cDSA::sMatrixInfo &matrix_info = dsa_->GetMatrixInfo(mid);
-          msg_pressure_list.pressure_list[mid].cells_x = matrix_info.cells_x;
-          msg_pressure_list.pressure_list[mid].cells_y = matrix_info.cells_y;
-          msg_pressure_list.pressure_list[mid].pressure.resize(matrix_info.cells_x * matrix_info.cells_y);
-
-          for (uint y(0); y < matrix_info.cells_y; y++) {
-            for (uint x(0); x < matrix_info.cells_x; x++) {
-              // convert voltage to pressure in Pascal
-              msg_pressure_list.pressure_list[mid].pressure[matrix_info.cells_x * y + x] =
-                      dsa_->GetTexel(mid, x, y) * dsa_calib_pressure_ / dsa_calib_voltage_ * 1e6;
-            }
-          }
-        } // part
-      } // finger
-      topicPub_Pressure_.publish(msg_pressure_list);
+  void runLoop(double frequency, void (SdhNode::*update)(), schunk_sdh_ros::CycleStats *stats)
+  {
+    stats->setNominalPeriod(1.0 / frequency);
+    ros::Rate loop_rate(frequency);  // Hz
+    while (running_ && ros::ok())
+    {
+      const schunk_sdh_ros::CycleStats::Clock::time_point start = schunk_sdh_ros::CycleStats::Clock::now();
+      (this->*update)();
+      stats->update(start, schunk_sdh_ros::CycleStats::Clock::now());
+      loop_rate.sleep();
     }
   }
+
+  static void addCycleStats(const std::string &prefix, const schunk_sdh_ros::CycleStats::Summary &summary,
+                            diagnostic_msgs::DiagnosticStatus &status)
+  {
+    diagnostic_msgs::KeyValue kv;
+    kv.key = prefix + "_rate";
+    kv.value = boost::lexical_cast<std::string>(summary.rate);
+    status.values.push_back(kv);
+    kv.key = prefix + "_period_max";
+    kv.value = boost::lexical_cast<std::string>(summary.period_max);
+    status.values.push_back(kv);
+    kv.key = prefix + "_work_mean";
+    kv.value = boost::lexical_cast<std::string>(summary.work_mean);
+    status.values.push_back(kv);
+    kv.key = prefix + "_work_max";
+    kv.value = boost::lexical_cast<std::string>(summary.work_max);
+    status.values.push_back(kv);
+    kv.key = prefix + "_overruns";
+    kv.value = boost::lexical_cast<std::string>(summary.overruns);
+    status.values.push_back(kv);
+  }
 };
 
+const std::vector<std::string> SdhNode::finger_names_ = {"finger_2", "thumb", "finger_1"};  // SDHLibrary order
+
 const std::vector<std::string> SdhNode::temperature_names_ = {
     "root",
     "proximal_finger_1", "distal_finger_1",
@@ -992,9 +1962,6 @@ const std::vector<std::string> SdhNode::temperature_names_ = {
     "controller", "pcb"
 };
 
-const std::vector<std::string> SdhNode::finger_names_ = {
-  "finger_2", "thumb_", "finger_1"
-};
 // SdhNode
 
 /*!
@@ -1024,6 +1991,27 @@ int main(int argc, char** argv)
     frequency = 5;  // Hz
     ROS_WARN("Parameter frequency not available, setting to default value: %f Hz", frequency);
   }
+  sdh_node.setupScheduler(frequency);
+  sdh_node.startDsaReader();
+
+  bool threaded;
+  sdh_node.nh_.param("threaded", threaded, false);
+  if (threaded)
+  {
+    double dsa_frequency;
+    int spinner_threads;
+    sdh_node.nh_.param("dsa_frequency", dsa_frequency, frequency);
+    sdh_node.nh_.param("spinner_threads", spinner_threads, 2);
+    ROS_INFO("running threaded: sdh at %f Hz, dsa at %f Hz, %d spinner threads", frequency, dsa_frequency,
+             spinner_threads);
+
+    ros::AsyncSpinner spinner(spinner_threads);
+    spinner.start();
+    sdh_node.startThreads(frequency, dsa_frequency);
+    ros::waitForShutdown();
+    sdh_node.stopThreads();
+    return 0;
+  }
 
   // sleep(1);
   ros::Rate loop_rate(frequency);  // Hz
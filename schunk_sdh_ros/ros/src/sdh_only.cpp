@@ -19,7 +19,12 @@
 // #### includes ####
 // standard includes
 #include <unistd.h>
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -42,10 +47,24 @@
 
 // ROS diagnostic msgs
 #include <diagnostic_msgs/DiagnosticArray.h>
+#include <diagnostic_msgs/KeyValue.h>
 
 // external includes
 #include <schunk_sdh/sdh.h>
 #include <schunk_sdh/util.h>
+
+#include <boost/lexical_cast.hpp>
+
+// package includes
+#include <schunk_sdh_ros/axis_snapshot.h>
+#include <schunk_sdh_ros/call_profiler.h>
+#include <schunk_sdh_ros/command_mailbox.h>
+#include <schunk_sdh_ros/feedback_messages.h>
+#include <schunk_sdh_ros/joint_mapping.h>
+#include <schunk_sdh_ros/signal_scheduler.h>
+#include <schunk_sdh_ros/triple_buffer.h>
+#include <schunk_sdh_ros/trajectory_sampler.h>
+
 /*!
  * \brief Implementation of ROS node for sdh.
  *
@@ -62,6 +81,7 @@ private:
   ros::Publisher topicPub_JointState_;
   ros::Publisher topicPub_ControllerState_;
   ros::Publisher topicPub_Diagnostics_;
+  ros::Publisher topicPub_CallStats_;
   ros::Publisher topicPub_Temperature_;
 
   // topic subscribers
@@ -86,7 +106,6 @@ private:
 
   // other variables
   SDH::cSDH *sdh_;
-  std::vector<SDH::cSDH::eAxisState> state_;
 
   std::string sdhdevicetype_;
   std::string sdhdevicestring_;
@@ -97,15 +116,45 @@ private:
   bool isInitialized_;
   bool isError_;
   int DOF_;
-  double pi_;
 
   trajectory_msgs::JointTrajectory traj_;
 
   std::vector<std::string> joint_names_;
+  schunk_sdh_ros::JointMapping joint_mapping_;  // joint order <-> axis order
+  std::vector<int> goal_index_of_axis_;  // only used by executeCB
+  schunk_sdh_ros::TrajectorySampler sampler_;  // only used by executeCB
+  schunk_sdh_ros::TripleBuffer<schunk_sdh_ros::StampedAngles> actual_angles_;  // written by updateSdh
+  std::atomic<bool> streaming_;  // executeCB streams setpoints, updateSdh must not stop the hand in between
+  double frequency_;  // rate of updateSdh
+  double trajectory_position_gain_;  // velocity mode streaming: correction of the position error [1/s]
+
+  // end of the motion to a position target, detected by updateSdh and waited for by executeCB
+  std::mutex motion_mutex_;
+  std::condition_variable motion_cond_;
+  uint64_t motion_done_seq_;  // last command whose motion finished, guarded by motion_mutex_
+  std::chrono::steady_clock::time_point motion_done_;  // time the motion finished, guarded by motion_mutex_
+  uint64_t motion_seq_;  // command whose motion is tracked by updateSdh, 0 if none
+  bool motion_started_;  // an axis left idle since the command was delivered
+  std::chrono::steady_clock::time_point motion_delivered_;
+  double position_tolerance_;  // default goal tolerance, in degrees
+  double default_goal_time_tolerance_;  // for streamed goals without goal_time_tolerance [s]
+  schunk_sdh_ros::TripleBuffer<std::vector<double> > goal_tolerance_;  // in degrees, written by executeCB
+  std::vector<double> motion_tolerance_;  // goal tolerance of the tracked motion
+  bool motion_tolerance_checked_;  // any axis of motion_tolerance_ is checked
+  bool motion_done_within_;  // the finished motion ended within the goal tolerance, guarded by motion_mutex_
+  double motion_start_timeout_;  // [s]
+  std::atomic<double> goal_duration_last_;  // goal accepted to result sent [s]
+  std::atomic<double> goal_completion_latency_last_;  // end of motion detected to result sent [s]
+
   std::vector<int> axes_;
   std::vector<double> targetAngles_;  // in degrees
-  std::vector<double> velocities_;  // in rad/s
-  bool hasNewGoal_;
+  std::vector<double> velocities_;  // in deg/s
+  schunk_sdh_ros::AxisSnapshot snapshot_;  // last feedback, only used by the update loop
+  schunk_sdh_ros::SignalScheduler scheduler_;  // rates of the individual feedback signals
+  schunk_sdh_ros::CallProfiler profiler_;  // latencies of the hardware calls, published on call_stats
+  int sig_angles_, sig_velocities_, sig_state_, sig_temperature_, sig_diagnostics_;
+  schunk_sdh_ros::CommandMailbox<std::vector<double> > command_;  // target angles or velocities in axis order
+  schunk_sdh_ros::FeedbackMessages feedbackMsgs_;  // published messages, reused once roscpp released them
   std::string operationMode_;
   std::vector<double> max_velocities_;
 
@@ -121,9 +170,18 @@ public:
       as_(nh_, name, boost::bind(&SdhNode::executeCB, this, _1), false), action_name_(name)
   {
     nh_ = ros::NodeHandle("~");
-    pi_ = 3.1415926;
     isError_ = false;
-
+    streaming_ = false;
+    frequency_ = 100.0;
+    motion_done_seq_ = 0;
+    motion_seq_ = 0;
+    motion_started_ = false;
+    motion_tolerance_checked_ = false;
+    motion_done_within_ = false;
+    goal_duration_last_ = 0.0;
+    goal_completion_latency_last_ = 0.0;
+
+    as_.registerPreemptCallback(boost::bind(&SdhNode::preemptCB, this));
     as_.start();
   }
 
@@ -144,13 +202,13 @@ public:
   {
     // initialize member variables
     isInitialized_ = false;
-    hasNewGoal_ = false;
 
     // implementation of topics to publish
     topicPub_JointState_ = nh_.advertise<sensor_msgs::JointState>("joint_states", 1);
     topicPub_ControllerState_ = nh_.advertise<control_msgs::JointTrajectoryControllerState>(
         "joint_trajectory_controller/state", 1);
     topicPub_Diagnostics_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    topicPub_CallStats_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("call_stats", 1);
     topicPub_Temperature_ = nh_.advertise<schunk_sdh::TemperatureArray>("temperature", 1);
 
     // pointer to sdh
@@ -202,6 +260,13 @@ public:
       joint_names_[i] = (std::string)joint_names_param[i];
     }
     std::cout << "joint_names = " << joint_names_param << std::endl;
+    std::string mapping_error;
+    if (!joint_mapping_.init(joint_names_, mapping_error))
+    {
+      ROS_ERROR("Parameter joint_names invalid (%s), shutting down node...", mapping_error.c_str());
+      nh_.shutdown();
+      return false;
+    }
 
     // define axes to send to sdh
     axes_.resize(DOF_);
@@ -212,9 +277,21 @@ public:
     }
     ROS_INFO("DOF = %d", DOF_);
 
-    state_.resize(axes_.size());
+    command_.reset(std::vector<double>(DOF_));
+    schunk_sdh_ros::StampedAngles stamped_angles;
+    stamped_angles.angles.resize(DOF_);
+    actual_angles_.reset(stamped_angles);
+
+    feedbackMsgs_.reset(joint_mapping_, joint_names_, temperature_names_);
+
 
     nh_.param("OperationMode", operationMode_, std::string("position"));
+    nh_.param("trajectory_position_gain", trajectory_position_gain_, 2.0);
+    nh_.param("position_tolerance", position_tolerance_, 0.01);  // in rad
+    position_tolerance_ *= schunk_sdh_ros::kDegPerRad;
+    nh_.param("motion_start_timeout", motion_start_timeout_, 0.5);
+    nh_.param("goal_time_tolerance", default_goal_time_tolerance_, 1.0);
+    goal_tolerance_.reset(std::vector<double>(DOF_, position_tolerance_));
     return true;
   }
   /*!
@@ -224,17 +301,22 @@ public:
    */
   bool switchOperationMode(const std::string &mode)
   {
-    hasNewGoal_ = false;
-    sdh_->Stop();
+    command_.discard();
+    {
+      schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_STOP);
+      sdh_->Stop();
+    }
 
     try
     {
       if (mode == "position")
       {
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_CONTROLLER);
         sdh_->SetController(SDH::cSDH::eCT_POSE);
       }
       else if (mode == "velocity")
       {
+        schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_CONTROLLER);
         sdh_->SetController(SDH::cSDH::eCT_VELOCITY);
       }
       else
@@ -264,9 +346,10 @@ public:
   void executeCB(const control_msgs::FollowJointTrajectoryGoalConstPtr &goal)
   {
     ROS_INFO("sdh: executeCB");
-    if (operationMode_ != "position")
+    control_msgs::FollowJointTrajectoryResult result;
+    if (operationMode_ != "position" && operationMode_ != "velocity")
     {
-      ROS_ERROR("%s: Rejected, sdh not in position mode", action_name_.c_str());
+      ROS_ERROR("%s: Rejected, sdh neither in position nor in velocity mode", action_name_.c_str());
       as_.setAborted();
       return;
     }
@@ -277,70 +360,377 @@ public:
       return;
     }
 
-    if (goal->trajectory.points.empty() || goal->trajectory.points[0].positions.size() != size_t(DOF_))
+    if (goal->trajectory.points.empty()
+        || goal->trajectory.points[0].positions.size() != goal->trajectory.joint_names.size())
     {
       ROS_ERROR("%s: Rejected, malformed FollowJointTrajectoryGoal", action_name_.c_str());
-      as_.setAborted();
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = "malformed FollowJointTrajectoryGoal";
+      as_.setAborted(result);
       return;
     }
-    while (hasNewGoal_ == true)
-      usleep(10000);
+    // the goal tolerance defaults to position_tolerance, path tolerances are off unless given
+    std::vector<double> goal_tolerance, path_tolerance;
+    if (!joint_mapping_.indexOfAxes(goal->trajectory.joint_names, goal_index_of_axis_)
+        || !axisTolerances(goal->goal_tolerance, position_tolerance_, goal_tolerance)
+        || !axisTolerances(goal->path_tolerance, -1.0, path_tolerance))
+    {
+      ROS_ERROR("%s: Rejected, joint names of the goal do not match joint_names", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_JOINTS;
+      result.error_string = "joint names do not match joint_names";
+      as_.setAborted(result);
+      return;
+    }
+    const double goal_time_tolerance = goal->goal_time_tolerance.toSec();
 
-    std::map<std::string, int> dict;
-    for (int idx = 0; idx < goal->trajectory.joint_names.size(); idx++)
+    // timed or multi-point trajectories are streamed, a single untimed point goes to the hand's own controller
+    if (goal->trajectory.points.size() > 1 || !goal->trajectory.points[0].time_from_start.isZero())
     {
-      dict[goal->trajectory.joint_names[idx]] = idx;
+      streamTrajectory(goal->trajectory, goal_tolerance, path_tolerance,
+                       goal_time_tolerance > 0.0 ? goal_time_tolerance : default_goal_time_tolerance_);
+      return;
+    }
+    if (operationMode_ != "position")
+    {
+      ROS_ERROR("%s: Rejected, a single point without time_from_start needs position mode", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = "a single point without time_from_start needs position mode";
+      as_.setAborted(result);
+      return;
     }
 
-    targetAngles_.resize(DOF_);
-    targetAngles_[0] = goal->trajectory.points[0].positions[dict["sdh_knuckle_joint"]] * 180.0 / pi_;  // sdh_knuckle_joint
-    targetAngles_[1] = goal->trajectory.points[0].positions[dict["sdh_finger_22_joint"]] * 180.0 / pi_;  // sdh_finger22_joint
-    targetAngles_[2] = goal->trajectory.points[0].positions[dict["sdh_finger_23_joint"]] * 180.0 / pi_;  // sdh_finger23_joint
-    targetAngles_[3] = goal->trajectory.points[0].positions[dict["sdh_thumb_2_joint"]] * 180.0 / pi_;  // sdh_thumb2_joint
-    targetAngles_[4] = goal->trajectory.points[0].positions[dict["sdh_thumb_3_joint"]] * 180.0 / pi_;  // sdh_thumb3_joint
-    targetAngles_[5] = goal->trajectory.points[0].positions[dict["sdh_finger_12_joint"]] * 180.0 / pi_;  // sdh_finger12_joint
-    targetAngles_[6] = goal->trajectory.points[0].positions[dict["sdh_finger_13_joint"]] * 180.0 / pi_;  // sdh_finger13_joint
+    std::vector<double> targetAngles(DOF_);
+    schunk_sdh_ros::JointMapping::gather(goal->trajectory.points[0].positions.data(), goal_index_of_axis_,
+                                         targetAngles.data());
+    schunk_sdh_ros::JointMapping::scale(targetAngles.data(), targetAngles.size(), schunk_sdh_ros::kDegPerRad);
     ROS_INFO(
-        "received position goal: [['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']] = [%f,%f,%f,%f,%f,%f,%f]",
-        goal->trajectory.points[0].positions[dict["sdh_knuckle_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_thumb_2_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_thumb_3_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_12_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_13_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_22_joint"]],
-        goal->trajectory.points[0].positions[dict["sdh_finger_23_joint"]]);
+        "received position goal: [knuckle, finger22, finger23, thumb2, thumb3, finger12, finger13] = [%f,%f,%f,%f,%f,%f,%f] deg",
+        targetAngles[0], targetAngles[1], targetAngles[2], targetAngles[3], targetAngles[4], targetAngles[5],
+        targetAngles[6]);
+
+    // handed to updateSdh together with the command, which publishes the buffer
+    goal_tolerance_.write(goal_tolerance);
+    const std::chrono::steady_clock::time_point goal_start = std::chrono::steady_clock::now();
+    const uint64_t seq = command_.post(targetAngles);
+
+    // updateSdh reports the end of the motion, preemption wakes us up as well
+    // without a goal_time_tolerance the goal waits until the hand comes to rest
+    const std::chrono::steady_clock::time_point deadline =
+        goal_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(goal_time_tolerance));
+    std::unique_lock<std::mutex> lock(motion_mutex_);
+    while (motion_done_seq_ < seq)
+    {
+      if (as_.isPreemptRequested() || !ros::ok())
+      {
+        lock.unlock();
+        holdPosition(false);  // the fingers must not keep moving to the cancelled target
+        ROS_WARN("%s: Preempted", action_name_.c_str());
+        as_.setPreempted();
+        return;
+      }
+      if (command_.discarded(seq) || !isInitialized_)
+      {
+        lock.unlock();
+        result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+        result.error_string = isInitialized_ ? "replaced by another command" : "sdh disconnected";
+        ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+        as_.setAborted(result);
+        return;
+      }
+      const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      if (goal_time_tolerance > 0.0 && now >= deadline)
+      {
+        lock.unlock();
+        ROS_WARN("%s: Aborted, goal not reached within goal_time_tolerance", action_name_.c_str());
+        result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+        result.error_string = "goal not reached within goal_time_tolerance";
+        as_.setAborted(result);
+        return;
+      }
+      std::chrono::steady_clock::time_point wakeup = now + std::chrono::milliseconds(100);
+      if (goal_time_tolerance > 0.0 && deadline < wakeup)
+        wakeup = deadline;
+      motion_cond_.wait_until(lock, wakeup);
+    }
+    const std::chrono::steady_clock::time_point motion_done = motion_done_;
+    const bool within = motion_done_within_;
+    lock.unlock();
 
-    hasNewGoal_ = true;
+    // an explicit goal tolerance has to be met, otherwise the hand coming to rest is good enough
+    if (!goal->goal_tolerance.empty() && !within)
+    {
+      ROS_WARN("%s: Aborted, hand stopped outside of goal_tolerance", action_name_.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+      result.error_string = "hand stopped outside of goal_tolerance";
+      as_.setAborted(result);
+      return;
+    }
 
-    usleep(500000);  // needed sleep until sdh starts to change status from idle to moving
+    // set the action state to succeeded
+    result.error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+    as_.setSucceeded(result);
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    goal_duration_last_ = std::chrono::duration<double>(now - goal_start).count();
+    goal_completion_latency_last_ = std::chrono::duration<double>(now - motion_done).count();
+    ROS_INFO("%s: Succeeded after %f s", action_name_.c_str(), goal_duration_last_.load());
+  }
 
-    bool finished = false;
-    while (finished == false)
+  /*!
+   * \brief Converts position tolerances of a goal to axis order.
+   *
+   * Follows control_msgs/JointTolerance: 0 selects the default, a negative value disables the check.
+   * \param tolerances tolerances of the goal [rad], joints not listed get the default
+   * \param default_tolerance tolerance in degrees, negative to disable
+   * \param axis_tolerance receives one tolerance per axis in degrees, negative if disabled
+   * \return false if a tolerance names an unknown joint
+   */
+  bool axisTolerances(const std::vector<control_msgs::JointTolerance> &tolerances, double default_tolerance,
+                      std::vector<double> &axis_tolerance) const
+  {
+    axis_tolerance.assign(axes_.size(), default_tolerance);
+    for (size_t i = 0; i < tolerances.size(); i++)
+    {
+      const std::vector<std::string>::const_iterator joint =
+          std::find(joint_names_.begin(), joint_names_.end(), tolerances[i].name);
+      if (joint == joint_names_.end())
+        return false;
+      const double position = tolerances[i].position;
+      if (position != 0.0)
+        axis_tolerance[joint_mapping_.axisOfJoint(joint - joint_names_.begin())] =
+            position > 0.0 ? position * schunk_sdh_ros::kDegPerRad : -1.0;
+    }
+    return true;
+  }
+
+  /*!
+   * \brief Finds the first axis outside of its tolerance.
+   *
+   * \param desired desired positions in axis order [deg]
+   * \param actual actual positions in axis order [deg]
+   * \param tolerance tolerances in axis order [deg], negative ones are not checked
+   * \return the axis or -1 if all checked axes are within their tolerance
+   */
+  static int firstViolation(const double *desired, const double *actual, const std::vector<double> &tolerance)
+  {
+    for (size_t a = 0; a < tolerance.size(); a++)
+    {
+      if (tolerance[a] >= 0.0 && std::fabs(desired[a] - actual[a]) > tolerance[a])
+        return a;
+    }
+    return -1;
+  }
+
+  /// wakes up executeCB when a new goal or a cancel request arrives
+  void preemptCB()
+  {
+    {
+      std::lock_guard<std::mutex> lock(motion_mutex_);
+    }
+    motion_cond_.notify_all();
+  }
+
+  /// starts tracking the motion to targetAngles_ of a delivered position command
+  void beginMotion(uint64_t seq)
+  {
+    motion_seq_ = seq;
+    motion_started_ = false;
+    motion_delivered_ = std::chrono::steady_clock::now();
+    goal_tolerance_.update();
+    motion_tolerance_ = goal_tolerance_.readBuffer();
+    motion_tolerance_checked_ = false;
+    for (size_t a = 0; a < motion_tolerance_.size(); a++)
+      motion_tolerance_checked_ = motion_tolerance_checked_ || motion_tolerance_[a] >= 0.0;
+  }
+
+  /*!
+   * \brief Checks whether the tracked motion finished and wakes up executeCB.
+   *
+   * The motion is finished as soon as all axes are within the goal tolerance of the target, or when all axes are idle
+   * after one of them moved. If no axis leaves idle (blocked or already there) the motion ends after
+   * motion_start_timeout.
+   */
+  void updateMotion()
+  {
+    if (motion_seq_ == 0)
+      return;
+
+    bool idle = false;
+    if (snapshot_.updated & schunk_sdh_ros::SIGNAL_STATE)
+    {
+      idle = true;
+      for (size_t i = 0; i < snapshot_.state.size(); i++)
+        idle = idle && snapshot_.state[i] == SDH::cSDH::eAS_IDLE;
+      if (!idle)
+        motion_started_ = true;
+    }
+    const bool within = snapshot_.angles.size() == targetAngles_.size()
+        && targetAngles_.size() == motion_tolerance_.size()
+        && firstViolation(targetAngles_.data(), snapshot_.angles.data(), motion_tolerance_) < 0;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const bool timeout = std::chrono::duration<double>(now - motion_delivered_).count() > motion_start_timeout_;
+    if (!(within && motion_tolerance_checked_) && !(idle && (motion_started_ || timeout)))
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(motion_mutex_);
+      motion_done_seq_ = motion_seq_;
+      motion_done_ = now;
+      motion_done_within_ = within;
+    }
+    motion_cond_.notify_all();
+    motion_seq_ = 0;
+  }
+
+  /*!
+   * \brief Streams a timed trajectory to the hand at the rate of updateSdh.
+   *
+   * The trajectory is sampled with cubic splines starting at its header stamp (or now). In position mode the sampled
+   * positions are sent as targets, in velocity mode the sampled velocities plus a proportional correction of the
+   * position error. Desired, actual and error are published as action feedback. The goal aborts as soon as an axis
+   * leaves its path tolerance, and succeeds as soon as all axes are within the goal tolerance after the last point.
+   * \param trajectory trajectory of the goal, joint names already mapped to goal_index_of_axis_
+   * \param goal_tolerance tolerance of the final position in axis order [deg], negative if not checked
+   * \param path_tolerance tolerance while moving in axis order [deg], negative if not checked
+   * \param goal_time_tolerance time allowed after the last point to get within the goal tolerance [s]
+   */
+  void streamTrajectory(const trajectory_msgs::JointTrajectory &trajectory, const std::vector<double> &goal_tolerance,
+                        const std::vector<double> &path_tolerance, double goal_time_tolerance)
+  {
+    control_msgs::FollowJointTrajectoryResult result;
+    std::string error;
+    actual_angles_.update();
+    if (!sampler_.init(trajectory, goal_index_of_axis_, actual_angles_.readBuffer().angles, error))
+    {
+      ROS_ERROR("%s: Rejected, %s", action_name_.c_str(), error.c_str());
+      result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+      result.error_string = error;
+      as_.setAborted(result);
+      return;
+    }
+    const bool velocity_mode = (operationMode_ == "velocity");
+    ROS_INFO("%s: streaming %d points over %f s in %s mode", action_name_.c_str(),
+             static_cast<int>(trajectory.points.size()), sampler_.duration(), operationMode_.c_str());
+
+    std::vector<double> position(DOF_), velocity(DOF_), setpoint(DOF_);
+    std::vector<double> reference(DOF_), reference_velocity(DOF_);  // desired at the time of the actual angles
+    control_msgs::FollowJointTrajectoryFeedback feedback;
+    feedback.joint_names = joint_names_;
+    feedback.desired.positions.resize(DOF_);
+    feedback.desired.velocities.resize(DOF_);
+    feedback.actual.positions.resize(DOF_);
+    feedback.error.positions.resize(DOF_);
+
+    ros::Time start = trajectory.header.stamp;
+    if (start.isZero())
+      start = ros::Time::now();
+    ros::Rate rate(frequency_);
+    streaming_ = true;
+    bool reached = false;
+    while (ros::ok())
     {
-      if (as_.isNewGoalAvailable())
+      if (as_.isPreemptRequested())
       {
-        ROS_WARN("%s: Aborted", action_name_.c_str());
-        as_.setAborted();
+        holdPosition(velocity_mode);
+        ROS_WARN("%s: Preempted", action_name_.c_str());
+        as_.setPreempted();
         return;
       }
-      for (unsigned int i = 0; i < state_.size(); i++)
+
+      // the actual angles were acquired one or two cycles ago, errors compare them with the desired angles of then
+      const double t = (ros::Time::now() - start).toSec();
+      sampler_.sample(t, position.data(), velocity.data());
+      actual_angles_.update();
+      const schunk_sdh_ros::StampedAngles &stamped_actual = actual_angles_.readBuffer();
+      const std::vector<double> &actual = stamped_actual.angles;
+      const double t_actual = (stamped_actual.stamp - start).toSec();
+      sampler_.sample(t_actual, reference.data(), reference_velocity.data());
+      if (velocity_mode)
+      {
+        for (int a = 0; a < DOF_; a++)
+          setpoint[a] = velocity[a] + trajectory_position_gain_ * (reference[a] - actual[a]);
+        command_.post(setpoint);
+      }
+      else
+      {
+        command_.post(position);
+      }
+
+      feedback.header.stamp = stamped_actual.stamp;
+      joint_mapping_.axesToJointsRad(reference.data(), feedback.desired.positions.data());
+      joint_mapping_.axesToJointsRad(reference_velocity.data(), feedback.desired.velocities.data());
+      joint_mapping_.axesToJointsRad(actual.data(), feedback.actual.positions.data());
+      for (int j = 0; j < DOF_; j++)
+        feedback.error.positions[j] = feedback.desired.positions[j] - feedback.actual.positions[j];
+      as_.publishFeedback(feedback);
+
+      if (t < sampler_.duration())
       {
-        ROS_DEBUG("state[%d] = %d", i, state_[i]);
-        if (state_[i] == 0)
+        const int axis = firstViolation(reference.data(), actual.data(), path_tolerance);
+        if (axis >= 0)
         {
-          finished = true;
+          holdPosition(velocity_mode);
+          result.error_code = control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
+          result.error_string = joint_names_[joint_mapping_.jointOfAxis(axis)] + " left its path tolerance";
+          ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+          as_.setAborted(result);
+          return;
         }
-        else
+      }
+      else
+      {
+        const int axis = firstViolation(position.data(), actual.data(), goal_tolerance);
+        if (axis < 0)
         {
-          finished = false;
+          reached = true;
+          break;
+        }
+        if (t > sampler_.duration() + goal_time_tolerance)
+        {
+          holdPosition(velocity_mode);
+          result.error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+          result.error_string = joint_names_[joint_mapping_.jointOfAxis(axis)] + " not within its goal tolerance";
+          ROS_WARN("%s: Aborted, %s", action_name_.c_str(), result.error_string.c_str());
+          as_.setAborted(result);
+          return;
         }
       }
-      usleep(10000);
+      // an overrun only delays the next cycle, the trajectory is sampled at the current time anyway
+      rate.sleep();
+    }
+    if (!reached)
+    {
+      holdPosition(velocity_mode);
+      ROS_WARN("%s: Preempted", action_name_.c_str());
+      as_.setPreempted();
+      return;
     }
 
-    // set the action state to succeeded
-    ROS_INFO("%s: Succeeded", action_name_.c_str());
-    as_.setSucceeded();
+    if (velocity_mode)
+    {
+      std::fill(setpoint.begin(), setpoint.end(), 0.0);
+      command_.post(setpoint);
+    }
+    streaming_ = false;
+
+    double max_error = 0.0;
+    for (int j = 0; j < DOF_; j++)
+      max_error = std::max(max_error, std::fabs(feedback.error.positions[j]));
+    ROS_INFO("%s: Succeeded, largest position error at the end %f rad", action_name_.c_str(), max_error);
+    result.error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+    as_.setSucceeded(result);
+  }
+
+  /// ends streaming and keeps the hand where it is
+  void holdPosition(bool velocity_mode)
+  {
+    actual_angles_.update();
+    if (velocity_mode)
+      command_.post(std::vector<double>(DOF_, 0.0));
+    else
+      command_.post(actual_angles_.readBuffer().angles);
+    streaming_ = false;
   }
 
   void topicCallback_setVelocitiesRaw(const std_msgs::Float64MultiArrayPtr& velocities)
@@ -361,19 +751,10 @@ public:
       return;
     }
 
-    // TODO: write proper lock!
-    while (hasNewGoal_ == true)
-      usleep(10000);
-
-    velocities_[0] = velocities->data[0] * 180.0 / pi_;  // sdh_knuckle_joint
-    velocities_[1] = velocities->data[5] * 180.0 / pi_;  // sdh_finger22_joint
-    velocities_[2] = velocities->data[6] * 180.0 / pi_;  // sdh_finger23_joint
-    velocities_[3] = velocities->data[1] * 180.0 / pi_;  // sdh_thumb2_joint
-    velocities_[4] = velocities->data[2] * 180.0 / pi_;  // sdh_thumb3_joint
-    velocities_[5] = velocities->data[3] * 180.0 / pi_;  // sdh_finger12_joint
-    velocities_[6] = velocities->data[4] * 180.0 / pi_;  // sdh_finger13_joint
+    std::vector<double> targetVelocities(DOF_);
+    joint_mapping_.jointsToAxesDeg(velocities->data.data(), targetVelocities.data());
 
-    hasNewGoal_ = true;
+    command_.post(targetVelocities);
   }
 
   /*!
@@ -515,7 +896,7 @@ public:
    */
   bool srvCallback_SetOperationMode(cob_srvs::SetString::Request &req, cob_srvs::SetString::Response &res)
   {
-    hasNewGoal_ = false;
+    command_.discard();
     sdh_->Stop();
     res.success = switchOperationMode(req.data);
     if (operationMode_ == "position")
@@ -651,6 +1032,70 @@ public:
 
   }
 
+  /*!
+   * \brief Publishes joint states, controller state and temperatures of an acquired snapshot.
+   *
+   * \param snapshot feedback read from the hand
+   */
+  void publishSnapshot(const schunk_sdh_ros::AxisSnapshot &snapshot)
+  {
+    if (snapshot.updated & schunk_sdh_ros::SIGNAL_TEMPERATURES)
+      publishTemperatures(snapshot);
+
+    // joint states follow the angle rate, velocities are taken from the last read
+    if (!(snapshot.updated & schunk_sdh_ros::SIGNAL_ANGLES) || snapshot.velocities.size() != axes_.size())
+      return;
+
+    ROS_DEBUG("received %d angles from sdh", static_cast<int>(snapshot.angles.size()));
+
+    feedbackMsgs_.fillJointStates(snapshot, targetAngles_);
+    topicPub_JointState_.publish(feedbackMsgs_.jointState());
+    topicPub_JointState_.publish(feedbackMsgs_.mimicJoint());
+    topicPub_ControllerState_.publish(feedbackMsgs_.controllerState());
+  }
+
+  /*!
+   * \brief Publishes the temperatures of an acquired snapshot.
+   *
+   * \param snapshot feedback read from the hand
+   */
+  void publishTemperatures(const schunk_sdh_ros::AxisSnapshot &snapshot)
+  {
+    if (!feedbackMsgs_.fillTemperatures(snapshot))
+    {
+      ROS_ERROR("amount of temperatures mismatch with stored names");
+      return;
+    }
+    topicPub_Temperature_.publish(feedbackMsgs_.temperatures());
+  }
+
+  /*!
+   * \brief Sets up the rates of the feedback signals.
+   *
+   * Rates are read from the parameters signal_rates/{angles,velocities,state,temperature,diagnostics} and capped at the
+   * loop frequency. Slow signals are spread over different cycles.
+   * \param frequency rate at which updateSdh() is called [Hz]
+   */
+  void setupScheduler(double frequency)
+  {
+    frequency_ = frequency;
+    double angles, velocities, state, temperature, diagnostics;
+    nh_.param("signal_rates/angles", angles, frequency);
+    nh_.param("signal_rates/velocities", velocities, frequency);
+    nh_.param("signal_rates/state", state, frequency);
+    nh_.param("signal_rates/temperature", temperature, 1.0);
+    nh_.param("signal_rates/diagnostics", diagnostics, 1.0);
+
+    scheduler_.reset(frequency);
+    sig_angles_ = scheduler_.add("angles", angles);
+    sig_velocities_ = scheduler_.add("velocities", velocities);
+    sig_state_ = scheduler_.add("state", state);
+    sig_temperature_ = scheduler_.add("temperature", temperature);
+    sig_diagnostics_ = scheduler_.add("diagnostics", diagnostics);
+    for (int id = sig_angles_; id <= sig_diagnostics_; id++)
+      ROS_INFO("%s published at %f Hz", scheduler_.name(id).c_str(), scheduler_.rate(id));
+  }
+
   /*!
    * \brief Main routine to update sdh.
    *
@@ -659,43 +1104,75 @@ public:
   void updateSdh()
   {
     ROS_DEBUG("updateJointState");
+    // signals to serve in this cycle
+    unsigned int signals = 0;
+    if (scheduler_.due(sig_angles_))
+      signals |= schunk_sdh_ros::SIGNAL_ANGLES;
+    if (scheduler_.due(sig_velocities_))
+      signals |= schunk_sdh_ros::SIGNAL_VELOCITIES;
+    if (scheduler_.due(sig_state_))
+      signals |= schunk_sdh_ros::SIGNAL_STATE;
+    if (scheduler_.due(sig_temperature_))
+      signals |= schunk_sdh_ros::SIGNAL_TEMPERATURES;
+    const bool publish_diagnostics = scheduler_.due(sig_diagnostics_);
+    scheduler_.tick();
+
+    bool has_snapshot = false;
     if (isInitialized_ == true)
     {
-      if (hasNewGoal_ == true)
+      const schunk_sdh_ros::CommandMailbox<std::vector<double> >::Command *command = command_.fetch();
+      if (command)
       {
-        // stop sdh first when new goal arrived
-        try
+        // stop sdh first when new goal arrived, streamed setpoints continue the running motion
+        if (!streaming_)
         {
-          sdh_->Stop();
-        }
-        catch (SDH::cSDHLibraryException* e)
-        {
-          ROS_ERROR("An exception was caught: %s", e->what());
-          delete e;
+          try
+          {
+            schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_STOP);
+            sdh_->Stop();
+          }
+          catch (SDH::cSDHLibraryException* e)
+          {
+            ROS_ERROR("An exception was caught: %s", e->what());
+            delete e;
+          }
         }
 
         if (operationMode_ == "position")
         {
           ROS_DEBUG("moving sdh in position mode");
 
+          targetAngles_ = command->value;
           try
           {
-            sdh_->SetAxisTargetAngle(axes_, targetAngles_);
-            sdh_->MoveHand(false);
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_ANGLE);
+              sdh_->SetAxisTargetAngle(axes_, targetAngles_);
+            }
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_MOVE_HAND);
+              sdh_->MoveHand(false);
+            }
           }
           catch (SDH::cSDHLibraryException* e)
           {
             ROS_ERROR("An exception was caught: %s", e->what());
             delete e;
           }
+          if (!streaming_)
+            beginMotion(command->seq);
         }
         else if (operationMode_ == "velocity")
         {
           ROS_DEBUG("moving sdh in velocity mode");
+          velocities_ = command->value;
           try
           {
         	clampVelocities();
-            sdh_->SetAxisTargetVelocity(axes_, velocities_);
+            {
+              schunk_sdh_ros::CallProfiler::Scope scope(&profiler_, schunk_sdh_ros::CALL_SET_AXIS_TARGET_VELOCITY);
+              sdh_->SetAxisTargetVelocity(axes_, velocities_);
+            }
             // ROS_DEBUG_STREAM("velocities: " << velocities_[0] << " "<< velocities_[1] << " "<< velocities_[2] << " "<< velocities_[3] << " "<< velocities_[4] << " "<< velocities_[5] << " "<< velocities_[6]);
           }
           catch (SDH::cSDHLibraryException* e)
@@ -716,134 +1193,41 @@ public:
                     operationMode_.c_str());
         }
 
-        hasNewGoal_ = false;
-      }
-
-      // read and publish joint angles and velocities
-      std::vector<double> actualAngles;
-      try
-      {
-        actualAngles = sdh_->GetAxisActualAngle(axes_);
-      }
-      catch (SDH::cSDHLibraryException* e)
-      {
-        ROS_ERROR("An exception was caught: %s", e->what());
-        delete e;
-      }
-      std::vector<double> actualVelocities;
-      try
-      {
-        actualVelocities = sdh_->GetAxisActualVelocity(axes_);
-      }
-      catch (SDH::cSDHLibraryException* e)
-      {
-        ROS_ERROR("An exception was caught: %s", e->what());
-        delete e;
+        command_.delivered(*command);
       }
 
-      ROS_DEBUG("received %d angles from sdh", static_cast<int>(actualAngles.size()));
-
-      ros::Time time = ros::Time::now();
-
-      // create joint_state message
-      sensor_msgs::JointState msg;
-      msg.header.stamp = time;
-      msg.name.resize(DOF_);
-      msg.position.resize(DOF_);
-      msg.velocity.resize(DOF_);
-      msg.effort.resize(DOF_);
-      // set joint names and map them to angles
-      msg.name = joint_names_;
-      // ['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']
-      // pos
-      msg.position[0] = actualAngles[0] * pi_ / 180.0;  // sdh_knuckle_joint
-      msg.position[1] = actualAngles[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-      msg.position[2] = actualAngles[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-      msg.position[3] = actualAngles[5] * pi_ / 180.0;  // sdh_finger_12_joint
-      msg.position[4] = actualAngles[6] * pi_ / 180.0;  // sdh_finger_13_joint
-      msg.position[5] = actualAngles[1] * pi_ / 180.0;  // sdh_finger_22_joint
-      msg.position[6] = actualAngles[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      // vel
-      msg.velocity[0] = actualVelocities[0] * pi_ / 180.0;  // sdh_knuckle_joint
-      msg.velocity[1] = actualVelocities[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-      msg.velocity[2] = actualVelocities[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-      msg.velocity[3] = actualVelocities[5] * pi_ / 180.0;  // sdh_finger_12_joint
-      msg.velocity[4] = actualVelocities[6] * pi_ / 180.0;  // sdh_finger_13_joint
-      msg.velocity[5] = actualVelocities[1] * pi_ / 180.0;  // sdh_finger_22_joint
-      msg.velocity[6] = actualVelocities[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      // publish message
-      topicPub_JointState_.publish(msg);
-
-      // because the robot_state_publisher doesn't know about the mimic joint, we have to publish the coupled joint separately
-      sensor_msgs::JointState mimicjointmsg;
-      mimicjointmsg.header.stamp = time;
-      mimicjointmsg.name.resize(1);
-      mimicjointmsg.position.resize(1);
-      mimicjointmsg.velocity.resize(1);
-      mimicjointmsg.name[0] = "schunk_right_finger_21_joint";
-      mimicjointmsg.position[0] = msg.position[0];  // sdh_knuckle_joint = sdh_finger_21_joint
-      mimicjointmsg.velocity[0] = msg.velocity[0];  // sdh_knuckle_joint = sdh_finger_21_joint
-      topicPub_JointState_.publish(mimicjointmsg);
-
-      // publish controller state message
-      control_msgs::JointTrajectoryControllerState controllermsg;
-      controllermsg.header.stamp = time;
-      controllermsg.joint_names.resize(DOF_);
-      controllermsg.desired.positions.resize(DOF_);
-      controllermsg.desired.velocities.resize(DOF_);
-      controllermsg.actual.positions.resize(DOF_);
-      controllermsg.actual.velocities.resize(DOF_);
-      controllermsg.error.positions.resize(DOF_);
-      controllermsg.error.velocities.resize(DOF_);
-      // set joint names and map them to angles
-      controllermsg.joint_names = joint_names_;
-      // ['sdh_knuckle_joint', 'sdh_thumb_2_joint', 'sdh_thumb_3_joint', 'sdh_finger_12_joint', 'sdh_finger_13_joint', 'sdh_finger_22_joint', 'sdh_finger_23_joint']
-      // desired pos
-      if (targetAngles_.size() != 0)
+      // read the due signals in one acquisition
+      if (signals != 0
+          && schunk_sdh_ros::readAxisSnapshot(*sdh_, axes_, sdh_->all_temperature_sensors, signals, snapshot_,
+                                             &profiler_))
       {
-        controllermsg.desired.positions[0] = targetAngles_[0] * pi_ / 180.0;  // sdh_knuckle_joint
-        controllermsg.desired.positions[1] = targetAngles_[3] * pi_ / 180.0;  // sdh_thumb_2_joint
-        controllermsg.desired.positions[2] = targetAngles_[4] * pi_ / 180.0;  // sdh_thumb_3_joint
-        controllermsg.desired.positions[3] = targetAngles_[5] * pi_ / 180.0;  // sdh_finger_12_joint
-        controllermsg.desired.positions[4] = targetAngles_[6] * pi_ / 180.0;  // sdh_finger_13_joint
-        controllermsg.desired.positions[5] = targetAngles_[1] * pi_ / 180.0;  // sdh_finger_22_joint
-        controllermsg.desired.positions[6] = targetAngles_[2] * pi_ / 180.0;  // sdh_finger_23_joint
-      }
-      // desired vel
-      // they are all zero
-      // actual pos
-      controllermsg.actual.positions = msg.position;
-      // actual vel
-      controllermsg.actual.velocities = msg.velocity;
-      // error, calculated out of desired and actual values
-      for (int i = 0; i < DOF_; i++)
-      {
-        controllermsg.error.positions[i] = controllermsg.desired.positions[i] - controllermsg.actual.positions[i];
-        controllermsg.error.velocities[i] = controllermsg.desired.velocities[i] - controllermsg.actual.velocities[i];
-      }
-      // publish controller message
-      topicPub_ControllerState_.publish(controllermsg);
-
-      // read sdh status
-      state_ = sdh_->GetAxisActualState(axes_);
-
-      // publish temperature
-      schunk_sdh::TemperatureArray temp_array;
-      temp_array.header.stamp = time;
-      const std::vector<double> temp_value = sdh_->GetTemperature(sdh_->all_temperature_sensors);
-      if(temp_value.size()==temperature_names_.size()) {
-          temp_array.name = temperature_names_;
-          temp_array.temperature = temp_value;
-      }
-      else {
-          ROS_ERROR("amount of temperatures mismatch with stored names");
+        if (snapshot_.updated & schunk_sdh_ros::SIGNAL_ANGLES)
+        {
+          schunk_sdh_ros::StampedAngles &angles = actual_angles_.writeBuffer();
+          angles.stamp = snapshot_.stamp;
+          angles.angles = snapshot_.angles;
+          actual_angles_.publish();
+        }
+        updateMotion();
+        has_snapshot = true;
       }
-      topicPub_Temperature_.publish(temp_array);
     }
     else
     {
       ROS_DEBUG("sdh not initialized");
     }
+
+    if (has_snapshot)
+      publishSnapshot(snapshot_);
+
+    if (!publish_diagnostics)
+      return;
+
+    // latencies of the hardware calls since the last report
+    diagnostic_msgs::DiagnosticArray call_stats;
+    profiler_.summarize(nh_.getNamespace() + "/", call_stats);
+    topicPub_CallStats_.publish(call_stats);
+
     // publishing diagnotic messages
     diagnostic_msgs::DiagnosticArray diagnostics;
     diagnostics.status.resize(1);
@@ -861,6 +1245,25 @@ public:
         diagnostics.status[0].level = 0;
         diagnostics.status[0].name = nh_.getNamespace();  // "schunk_powercube_chain";
         diagnostics.status[0].message = "sdh initialized and running";
+        diagnostic_msgs::KeyValue kv;
+        kv.key = "command_latency_last";
+        kv.value = boost::lexical_cast<std::string>(command_.latencyLast());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "command_latency_max";
+        kv.value = boost::lexical_cast<std::string>(command_.latencyMax());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "feedback_io_time";
+        kv.value = boost::lexical_cast<std::string>(snapshot_.io_time);
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "goal_duration_last";
+        kv.value = boost::lexical_cast<std::string>(goal_duration_last_.load());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "goal_completion_latency_last";
+        kv.value = boost::lexical_cast<std::string>(goal_completion_latency_last_.load());
+        diagnostics.status[0].values.push_back(kv);
+        kv.key = "message_allocations";
+        kv.value = boost::lexical_cast<std::string>(feedbackMsgs_.allocations());
+        diagnostics.status[0].values.push_back(kv);
       }
       else
       {
@@ -909,6 +1312,7 @@ int main(int argc, char** argv)
     frequency = 50;  // Hz
     ROS_WARN("Parameter frequency not available, setting to default value: %f Hz", frequency);
   }
+  sdh_node.setupScheduler(frequency);
 
   // sleep(1);
   ros::Rate loop_rate(frequency);  // Hz
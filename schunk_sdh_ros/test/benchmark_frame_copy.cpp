@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Per-frame cost of filling tactile_data, the former per-texel GetTexel() path against copyDsaFrame() followed by the
+// TactileDecoder. Timings are printed and recorded as test properties; the test only fails if both paths disagree.
+// Build with optimization (e.g. -DCMAKE_BUILD_TYPE=Release) for meaningful numbers.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/TactileSensor.h>
+#include <schunk_sdh/TactileMatrix.h>
+
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/tactile_decoder.h>
+
+#include "fake_dsa.h"
+
+namespace
+{
+
+const int kFrames = 20000;
+
+/// tactile_data as dsa_only built it before the frame copy: a new message, GetTexel() for every cell
+template<typename Sensor>
+void copyPerTexel(const Sensor &dsa, const std::vector<int> &reorder, schunk_sdh::TactileSensor &msg)
+{
+  int m, x, y;
+  msg.tactile_matrix.resize(dsa.GetSensorInfo().nb_matrices);
+  for (unsigned int i = 0; i < reorder.size(); i++)
+  {
+    m = reorder[i];
+    schunk_sdh::TactileMatrix &tm = msg.tactile_matrix[i];
+    tm.matrix_id = i;
+    tm.cells_x = dsa.GetMatrixInfo(m).cells_x;
+    tm.cells_y = dsa.GetMatrixInfo(m).cells_y;
+    tm.tactile_array.resize(tm.cells_x * tm.cells_y);
+    for (y = 0; y < tm.cells_y; y++)
+    {
+      for (x = 0; x < tm.cells_x; x++)
+        tm.tactile_array[tm.cells_x * y + x] = dsa.GetTexel(m, x, y);
+    }
+  }
+}
+
+/// a new frame with some texels changed
+void nextFrame(schunk_sdh_ros::FakeDsa &dsa, int k)
+{
+  dsa.advance(33);
+  for (int m = 0; m < 6; m++)
+    dsa.texel(m, k % 6, k % 13) = (k * 7 + m) % 4096;
+}
+
+double nanosecondsPerFrame(std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<double, std::nano>(duration).count() / kFrames;
+}
+
+}  // namespace
+
+TEST(FrameCopy, PerTexelAgainstBulk)
+{
+  const std::vector<int> reorder = {2, 3, 4, 5, 0, 1};
+  schunk_sdh_ros::FakeDsa dsa;
+
+  std::chrono::steady_clock::duration per_texel(0);
+  schunk_sdh::TactileSensor old_msg;
+  for (int k = 0; k < kFrames; k++)
+  {
+    nextFrame(dsa, k);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    schunk_sdh::TactileSensor msg;
+    copyPerTexel(dsa, reorder, msg);
+    per_texel += std::chrono::steady_clock::now() - start;
+    if (k == kFrames - 1)
+      old_msg = msg;
+  }
+
+  schunk_sdh_ros::FakeDsa bulk_dsa;
+  schunk_sdh_ros::DsaFrame frame;
+  schunk_sdh_ros::TactileDecoder decoder;
+  decoder.setLinearCalibration(1.0);
+  decoder.setReorder(reorder);
+  schunk_sdh::TactileSensor new_msg;
+  std::chrono::steady_clock::duration bulk(0);
+  for (int k = 0; k < kFrames; k++)
+  {
+    nextFrame(bulk_dsa, k);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    schunk_sdh_ros::copyDsaFrame(bulk_dsa, ros::Time(k * 0.033), k + 1, frame);
+    decoder.decode(frame, &new_msg, 0, 0);
+    bulk += std::chrono::steady_clock::now() - start;
+  }
+
+  ASSERT_EQ(old_msg.tactile_matrix.size(), new_msg.tactile_matrix.size());
+  for (size_t i = 0; i < old_msg.tactile_matrix.size(); i++)
+  {
+    EXPECT_EQ(old_msg.tactile_matrix[i].matrix_id, new_msg.tactile_matrix[i].matrix_id);
+    EXPECT_EQ(old_msg.tactile_matrix[i].cells_x, new_msg.tactile_matrix[i].cells_x);
+    EXPECT_EQ(old_msg.tactile_matrix[i].cells_y, new_msg.tactile_matrix[i].cells_y);
+    EXPECT_EQ(old_msg.tactile_matrix[i].tactile_array, new_msg.tactile_matrix[i].tactile_array);
+  }
+
+  const double per_texel_ns = nanosecondsPerFrame(per_texel);
+  const double bulk_ns = nanosecondsPerFrame(bulk);
+  std::printf("tactile_data per frame: GetTexel %.0f ns, copyDsaFrame + decode %.0f ns\n", per_texel_ns, bulk_ns);
+  RecordProperty("per_texel_ns", static_cast<int>(per_texel_ns));
+  RecordProperty("bulk_ns", static_cast<int>(bulk_ns));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
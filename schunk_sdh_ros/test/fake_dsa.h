@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SCHUNK_SDH_ROS_TEST_FAKE_DSA_H
+#define SCHUNK_SDH_ROS_TEST_FAKE_DSA_H
+
+#include <cstdint>
+#include <vector>
+
+#include <schunk_sdh/dsa.h>
+
+namespace schunk_sdh_ros
+{
+
+/*!
+ * \brief Stands in for SDH::cDSA in tests, with the accessors copyDsaFrame() uses.
+ *
+ * The layout is that of a standard SDH: three fingers with a proximal matrix of 6 x 14 and a distal matrix of 6 x 13
+ * texels, 486 texels in one frame buffer. Tests write the texels and advance the sensor timestamp themselves.
+ */
+class FakeDsa
+{
+public:
+  FakeDsa() :
+      matrix_info_(6)
+  {
+    sensor_info_ = SDH::cDSA::sSensorInfo();
+    sensor_info_.nb_matrices = matrix_info_.size();
+    offset_.assign(1, 0);
+    for (size_t m = 0; m < matrix_info_.size(); m++)
+    {
+      matrix_info_[m] = SDH::cDSA::sMatrixInfo();
+      matrix_info_[m].cells_x = 6;
+      matrix_info_[m].cells_y = (m % 2 == 0) ? 14 : 13;
+      matrix_info_[m].texel_width = 3.4f;
+      matrix_info_[m].texel_height = 3.4f;
+      offset_.push_back(offset_.back() + matrix_info_[m].cells_x * matrix_info_[m].cells_y);
+    }
+    texels_.assign(offset_.back(), 0);
+    frame_.timestamp = 0;
+    frame_.flags = 0;
+    frame_.texel = texels_.data();
+  }
+
+  const SDH::cDSA::sSensorInfo &GetSensorInfo() const
+  {
+    return sensor_info_;
+  }
+
+  const SDH::cDSA::sMatrixInfo &GetMatrixInfo(int m) const
+  {
+    return matrix_info_[m];
+  }
+
+  const SDH::cDSA::sTactileSensorFrame &GetFrame() const
+  {
+    return frame_;
+  }
+
+  int GetMatrixIndex(int fi, int part) const
+  {
+    return 2 * fi + part;
+  }
+
+  /// like cDSA::GetTexel(), kept out of line like the library call it stands for
+  __attribute__((noinline)) SDH::cDSA::tTexel GetTexel(int m, int x, int y) const
+  {
+    return texels_[offset_[m] + y * matrix_info_[m].cells_x + x];
+  }
+
+  /// texel \a x, \a y of matrix \a m in the frame buffer
+  SDH::cDSA::tTexel &texel(int m, int x, int y)
+  {
+    return texels_[offset_[m] + y * matrix_info_[m].cells_x + x];
+  }
+
+  /// starts the next frame \a dt_ms later, the texels keep their values
+  void advance(uint32_t dt_ms)
+  {
+    frame_.timestamp += dt_ms;
+  }
+
+private:
+  SDH::cDSA::sSensorInfo sensor_info_;
+  std::vector<SDH::cDSA::sMatrixInfo> matrix_info_;
+  std::vector<size_t> offset_;
+  std::vector<SDH::cDSA::tTexel> texels_;
+  SDH::cDSA::sTactileSensorFrame frame_;
+};
+
+}  // namespace schunk_sdh_ros
+
+#endif  // SCHUNK_SDH_ROS_TEST_FAKE_DSA_H
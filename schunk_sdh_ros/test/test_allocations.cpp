@@ -0,0 +1,191 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Counts the heap allocations of the steady-state publish paths. Every operator new of this binary is counted, so a
+// path is allocation-free if the counter does not move while it runs.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
+
+#include <schunk_sdh_ros/axis_snapshot.h>
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/feedback_messages.h>
+#include <schunk_sdh_ros/joint_mapping.h>
+#include <schunk_sdh_ros/reusable_message.h>
+
+#include "fake_dsa.h"
+
+static std::atomic<uint64_t> g_allocations(0);
+
+void *operator new(size_t size)
+{
+  ++g_allocations;
+  void *p = std::malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+
+const int kDof = 7;
+const int kFrames = 1000;
+
+/// what roscpp does with a published message without intra-process subscribers: it holds it during publish() only
+template<typename M>
+void publish(const boost::shared_ptr<M> &msg)
+{
+  boost::shared_ptr<const M> held(msg);
+}
+
+std::vector<std::string> jointNames()
+{
+  // a prefix longer than the small string buffer, in the order of the default joint_names parameter
+  const std::string prefix = "robot_with_a_long_name_sdh_";
+  std::vector<std::string> names;
+  names.push_back(prefix + "knuckle_joint");
+  names.push_back(prefix + "thumb_2_joint");
+  names.push_back(prefix + "thumb_3_joint");
+  names.push_back(prefix + "finger_12_joint");
+  names.push_back(prefix + "finger_13_joint");
+  names.push_back(prefix + "finger_22_joint");
+  names.push_back(prefix + "finger_23_joint");
+  return names;
+}
+
+}  // namespace
+
+TEST(Allocations, FeedbackMessages)
+{
+  const std::vector<std::string> joint_names = jointNames();
+  schunk_sdh_ros::JointMapping mapping;
+  std::string error;
+  ASSERT_TRUE(mapping.init(joint_names, error)) << error;
+  std::vector<std::string> temperature_names;
+  for (int t = 0; t < 9; t++)
+    temperature_names.push_back("temperature_sensor_with_a_long_name_" + std::to_string(t));
+  schunk_sdh_ros::FeedbackMessages msgs;
+  msgs.reset(mapping, joint_names, temperature_names);
+
+  schunk_sdh_ros::AxisSnapshot snapshot;
+  snapshot.angles.assign(kDof, 0.0);
+  snapshot.velocities.assign(kDof, 0.0);
+  snapshot.temperatures.assign(temperature_names.size(), 0.0);
+  const std::vector<double> target_angles(kDof, 10.0);
+
+  // the first cycle allocates the instances
+  msgs.fillJointStates(snapshot, target_angles);
+  ASSERT_TRUE(msgs.fillTemperatures(snapshot));
+  publish(msgs.jointState());
+  publish(msgs.mimicJoint());
+  publish(msgs.controllerState());
+  publish(msgs.temperatures());
+
+  // the per-cycle path of updateSdh: joint states at the angle rate, temperatures now and then
+  const uint64_t before = g_allocations;
+  for (int k = 0; k < kFrames; k++)
+  {
+    snapshot.stamp = ros::Time(k * 0.01);
+    for (int a = 0; a < kDof; a++)
+    {
+      snapshot.angles[a] = 0.1 * k + a;
+      snapshot.velocities[a] = 0.1 * a;
+    }
+    msgs.fillJointStates(snapshot, target_angles);
+    publish(msgs.jointState());
+    publish(msgs.mimicJoint());
+    publish(msgs.controllerState());
+    if (k % 100 == 0)
+    {
+      snapshot.temperatures[k / 100 % temperature_names.size()] = 0.1 * k;
+      ASSERT_TRUE(msgs.fillTemperatures(snapshot));
+      publish(msgs.temperatures());
+    }
+  }
+  EXPECT_EQ(0u, g_allocations - before);
+  EXPECT_EQ(4u, msgs.allocations());
+
+  // values end up in joint order, the mimic joint follows the knuckle
+  const int knuckle = mapping.jointOfAxis(0);
+  const int thumb_3 = mapping.jointOfAxis(4);
+  EXPECT_NEAR(snapshot.angles[4] * schunk_sdh_ros::kRadPerDeg, msgs.jointState()->position[thumb_3], 1e-9);
+  EXPECT_EQ(msgs.jointState()->position[knuckle], msgs.mimicJoint()->position[0]);
+  EXPECT_NEAR((10.0 - snapshot.angles[4]) * schunk_sdh_ros::kRadPerDeg,
+              msgs.controllerState()->error.positions[thumb_3], 1e-9);
+}
+
+TEST(Allocations, HeldMessageIsNotModified)
+{
+  sensor_msgs::JointState joint_state;
+  joint_state.name = jointNames();
+  joint_state.position.resize(kDof);
+  schunk_sdh_ros::ReusableMessage<sensor_msgs::JointState> msg;
+  msg.reset(joint_state);
+
+  // an intra-process subscriber keeps the published instance, the next cycle gets a fresh copy
+  boost::shared_ptr<const sensor_msgs::JointState> held = msg.acquire();
+  EXPECT_NE(held.get(), msg.acquire().get());
+  EXPECT_EQ(2u, msg.allocations());
+  held.reset();
+  const sensor_msgs::JointState *instance = msg.acquire().get();
+  EXPECT_EQ(instance, msg.acquire().get());
+  EXPECT_EQ(2u, msg.allocations());
+}
+
+TEST(Allocations, DsaFrameCopy)
+{
+  schunk_sdh_ros::FakeDsa dsa;
+  schunk_sdh_ros::DsaFrame frame;
+  schunk_sdh_ros::copyDsaFrame(dsa, ros::Time(0.0), 1, frame);  // builds the layout
+
+  const uint64_t before = g_allocations;
+  for (int k = 0; k < kFrames; k++)
+  {
+    dsa.advance(33);
+    dsa.texel(k % 6, k % 6, k % 13) = k % 4096;
+    schunk_sdh_ros::copyDsaFrame(dsa, ros::Time(k * 0.033), k + 2, frame);
+  }
+  EXPECT_EQ(0u, g_allocations - before);
+  EXPECT_EQ(486u, frame.texels.size());
+  EXPECT_EQ(dsa.GetFrame().timestamp, frame.timestamp);
+  EXPECT_EQ(dsa.GetTexel(5, 3, 12), frame.matrix(5)[12 * 6 + 3]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Replays synthetic grasps through the TactileDecoder and the SlipDetector like the DSA node does: a blob of pressure
+// on one matrix that stays, moves, jumps once or is disturbed for a single frame, with sensor noise on every frame.
+// The latency case prints and records the onset latency and the per-frame cost of update() as test properties.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <ros/ros.h>
+#include <schunk_sdh/dsa.h>
+
+#include <schunk_sdh_ros/dsa_frame.h>
+#include <schunk_sdh_ros/slip_detector.h>
+#include <schunk_sdh_ros/tactile_decoder.h>
+
+#include "fake_dsa.h"
+
+namespace
+{
+
+const int kMatrix = 2;           // proximal matrix of the second finger, 6 x 14
+const double kRate = 30.0;       // [Hz]
+const float kTexelSize = 3.4f;   // [mm], see FakeDsa
+
+/// frames of a 2 x 2 texel blob, decoded with the default contact thresholds of the DSA node
+class GraspReplay
+{
+public:
+  /// detector with its default thresholds
+  GraspReplay() :
+      k_(0), update_time_(0), updates_(0)
+  {
+    configureDecoder();
+  }
+
+  explicit GraspReplay(int min_frames) :
+      k_(0), update_time_(0), updates_(0)
+  {
+    configureDecoder();
+    detector_.setThresholds(20.0, 3.0, min_frames);
+  }
+
+  /*!
+   * \brief Replays the next frame.
+   *
+   * \param x, y texel of the blob's corner, x < 0 for no contact
+   * \return slips reported for this frame
+   */
+  std::vector<schunk_sdh_ros::Slip> step(int x, int y)
+  {
+    ++k_;
+    dsa_.advance(static_cast<uint32_t>(1000.0 / kRate));
+    for (int ty = 0; ty < 14; ty++)
+    {
+      for (int tx = 0; tx < 6; tx++)
+      {
+        const bool blob = x >= 0 && (tx == x || tx == x + 1) && (ty == y || ty == y + 1);
+        dsa_.texel(kMatrix, tx, ty) = blob ? 1000 + (k_ * 7 + tx * 3 + ty) % 9 : 0;  // a few raw units of noise
+      }
+    }
+    schunk_sdh_ros::copyDsaFrame(dsa_, ros::Time(k_ / kRate), k_, frame_);
+    decoder_.decode(frame_, 0, 0, &contacts_);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    detector_.update(frame_, contacts_, slips_);
+    update_time_ += std::chrono::steady_clock::now() - start;
+    ++updates_;
+    return slips_;
+  }
+
+  /// replays \a frames frames of a blob that stays at \a x, \a y, returns the number of slips reported
+  size_t hold(int x, int y, int frames)
+  {
+    size_t slips = 0;
+    for (int f = 0; f < frames; f++)
+      slips += step(x, y).size();
+    return slips;
+  }
+
+  /// stamp of the last replayed frame
+  ros::Time stamp() const
+  {
+    return frame_.stamp;
+  }
+
+  /// mean time of SlipDetector::update() over all replayed frames [ns]
+  double nanosecondsPerUpdate() const
+  {
+    return std::chrono::duration<double, std::nano>(update_time_).count() / std::max(updates_, 1);
+  }
+
+private:
+  void configureDecoder()
+  {
+    decoder_.setLinearCalibration(1.0);
+    decoder_.setReorder({2, 3, 4, 5, 0, 1});
+    decoder_.setContactThresholds(10.0, 10.0);
+  }
+
+  schunk_sdh_ros::FakeDsa dsa_;
+  schunk_sdh_ros::DsaFrame frame_;
+  schunk_sdh_ros::TactileDecoder decoder_;
+  std::vector<SDH::cDSA::sContactInfo> contacts_;
+  std::vector<schunk_sdh_ros::Slip> slips_;
+  schunk_sdh_ros::SlipDetector detector_;
+  int k_;
+  std::chrono::steady_clock::duration update_time_;
+  int updates_;
+};
+
+}  // namespace
+
+TEST(SlipDetector, SteadyGraspDoesNotSlip)
+{
+  GraspReplay replay(1);
+  EXPECT_EQ(0u, replay.hold(2, 5, 300));
+}
+
+TEST(SlipDetector, OnsetAfterMinFrames)
+{
+  GraspReplay replay(3);
+  EXPECT_EQ(0u, replay.hold(2, 3, 10));
+
+  // the blob slides one texel per frame, about 100 mm/s
+  EXPECT_TRUE(replay.step(2, 4).empty());
+  EXPECT_TRUE(replay.step(2, 5).empty());
+  std::vector<schunk_sdh_ros::Slip> slips = replay.step(2, 6);
+  ASSERT_EQ(1u, slips.size());
+  EXPECT_EQ(kMatrix, slips[0].matrix);
+  EXPECT_TRUE(slips[0].onset);
+  EXPECT_NEAR(0.0, slips[0].x_velocity, 1.0);
+  EXPECT_NEAR(kTexelSize * kRate, slips[0].y_velocity, 5.0);
+  EXPECT_GT(slips[0].change_rate, 3.0);
+
+  slips = replay.step(2, 7);
+  ASSERT_EQ(1u, slips.size());
+  EXPECT_FALSE(slips[0].onset);
+
+  // the object stops, the slip ends with the first pair that does not move and starts over afterwards
+  EXPECT_EQ(0u, replay.hold(2, 7, 10));
+  EXPECT_TRUE(replay.step(2, 8).empty());
+  EXPECT_TRUE(replay.step(2, 9).empty());
+  slips = replay.step(2, 10);
+  ASSERT_EQ(1u, slips.size());
+  EXPECT_TRUE(slips[0].onset);
+}
+
+TEST(SlipDetector, DebounceFiltersSingleJump)
+{
+  // the grasp settles one texel further, only the pair across the jump exceeds the thresholds
+  GraspReplay debounced;
+  EXPECT_EQ(0u, debounced.hold(2, 5, 10));
+  EXPECT_EQ(0u, debounced.step(2, 6).size());
+  EXPECT_EQ(0u, debounced.hold(2, 6, 10));
+
+  GraspReplay undebounced(1);
+  EXPECT_EQ(0u, undebounced.hold(2, 5, 10));
+  EXPECT_EQ(1u, undebounced.step(2, 6).size());
+  EXPECT_EQ(0u, undebounced.hold(2, 6, 10));
+}
+
+TEST(SlipDetector, DebounceFiltersSingleFrame)
+{
+  // one disturbed frame makes the pairs before and after it exceed the thresholds
+  GraspReplay debounced(3);
+  EXPECT_EQ(0u, debounced.hold(2, 5, 10));
+  EXPECT_EQ(0u, debounced.step(3, 5).size());
+  EXPECT_EQ(0u, debounced.hold(2, 5, 10));
+
+  GraspReplay default_debounced;
+  EXPECT_EQ(0u, default_debounced.hold(2, 5, 10));
+  EXPECT_EQ(0u, default_debounced.step(3, 5).size());
+  EXPECT_EQ(1u, default_debounced.hold(2, 5, 10));
+}
+
+TEST(SlipDetector, OnsetLatency)
+{
+  // grasps that slide by one texel per frame after a steady phase, detector with its default thresholds
+  GraspReplay replay;
+  double latency_max = 0.0;
+  for (int grasp = 0; grasp < 200; grasp++)
+  {
+    ASSERT_EQ(0u, replay.hold(-1, 0, 2));  // released
+    ASSERT_EQ(0u, replay.hold(2, 3, 20));
+    bool onset = false;
+    ros::Time first_moved;
+    for (int y = 4; y < 12 && !onset; y++)
+    {
+      const std::vector<schunk_sdh_ros::Slip> &slips = replay.step(2, y);
+      if (y == 4)
+        first_moved = replay.stamp();
+      onset = !slips.empty() && slips[0].onset;
+    }
+    ASSERT_TRUE(onset);
+    latency_max = std::max(latency_max, (replay.stamp() - first_moved).toSec() * 1000.0);
+  }
+  EXPECT_NEAR(1000.0 / kRate, latency_max, 1.0);  // one frame with min_frames 2
+
+  const double update_ns = replay.nanosecondsPerUpdate();
+  std::printf("slip onset latency %.1f ms at %.0f Hz, SlipDetector::update %.0f ns per frame\n", latency_max, kRate,
+              update_ns);
+  RecordProperty("onset_latency_ms", static_cast<int>(latency_max + 0.5));
+  RecordProperty("update_ns", static_cast<int>(update_ns));
+}
+
+TEST(SlipDetector, RegraspIsNotSlip)
+{
+  GraspReplay replay(1);
+  EXPECT_EQ(0u, replay.hold(1, 2, 10));
+  EXPECT_EQ(0u, replay.hold(-1, 0, 3));  // released
+  EXPECT_EQ(0u, replay.hold(3, 10, 10));  // grasped elsewhere
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}